@@ -1,4 +1,7 @@
 #include "Json.hpp"
+#include <assert.h>
+#include <sstream>
+#include <thread>
 
 int test1() {
     auto etxtext =
@@ -8,6 +11,16 @@ int test1() {
 
     std::string str = posdk::Json::decodeString(etxtext);
     auto tx = posdk::Json::loadFromString(str);
+
+    // a stream is read up to the end of the value, what follows stays in it
+    std::istringstream is(str + "[1, \"]\"] 7");
+    posdk::Json::Tree ts;
+    posdk::Json::load(is, "test1", ts);
+    assert(posdk::Json::saveToString(ts) == posdk::Json::saveToString(tx));
+    posdk::Json::load(is, "test1", ts);
+    assert(ts.size() == 2);
+    posdk::Json::load(is, "test1", ts);
+    assert(ts.getValue<int>() == 7);
     std::cout << "committing-1:" << posdk::Json::saveToString(tx) << std::endl;
     return 0;
 }
@@ -50,9 +63,522 @@ int test3() {
     return 0;
 }
 
+int test4() {
+    auto tx = posdk::Json::loadFromString("{\"a\":{\"b\":[1,2,3]},\"c\":\"d\"}");
+    posdk::Json::Tree moved(std::move(tx));
+    assert(moved.getChild("a").getChild("b").size() == 3);
+
+    posdk::Json::Tree parent(posdk::Json::DataType::Object);
+    parent.add("m", std::move(moved));
+    assert(parent.getChild("m").get<std::string>("c") == "d");
+    std::cout << "committing-4:" << posdk::Json::saveToString(parent, 0) << std::endl;
+    return 0;
+}
+
+int test5() {
+    posdk::Json::Tree tx(posdk::Json::DataType::Object);
+    for(int64_t i = 0; i < 40; ++i) {
+        tx.add("k" + std::to_string(i), i);
+    }
+    assert(tx.get<int64_t>("k3") == 3);
+    assert(tx.get<int64_t>("k39") == 39);
+    tx.erase("k3");
+    assert(tx.hasChild("k3") == nullptr);
+    assert(tx.get<int64_t>("k4") == 4);
+    tx.set("k4", static_cast<int64_t>(44));
+    assert(tx.get<int64_t>("k4") == 44);
+    std::string_view key("k10-suffix", 3);
+    assert(tx.getChild(key).getValue<int64_t>() == 10);
+    assert(tx.hasChild(std::string("k11")) != nullptr);
+
+    size_t count = 0;
+    for(auto& p : tx) {
+        assert(p.first.size() > 1);
+        ++count;
+    }
+    assert(count == 39);
+    std::cout << "committing-5:" << count << std::endl;
+    return 0;
+}
+
+int test6() {
+    std::string str = "{\"Record\":{\"DocumentID\":\"75d376cc-e3a5-4daa-89b5-8e3a476e9ec7\",\"Reply\":[1,2.5,true,null,\"qqq\"]}}";
+    posdk::Json::Arena arena(1024);
+    posdk::Json::Tree copy;
+    for(int i = 0; i < 3; ++i) {
+        auto& tx = posdk::Json::loadFromString(str, arena);
+        assert(tx.getChild("Record").get<std::string>("DocumentID") == "75d376cc-e3a5-4daa-89b5-8e3a476e9ec7");
+        assert(tx.getChild("Record").getChild("Reply").size() == 5);
+        copy = tx.getChild("Record");
+        arena.reset();
+    }
+    std::cout << "committing-6:" << posdk::Json::saveToString(copy, 0) << std::endl;
+    return 0;
+}
+
+int test7() {
+    std::string str = "{\"user id\":\"qqq@u.segito.net\",\"text\":\"line1\\nline2\",\"k\\\"q\":1}";
+    posdk::Json::ParseOptions opts;
+    opts.borrowStrings = true;
+    auto tx = posdk::Json::loadFromString(str, opts);
+
+    auto uid = tx.getChild("user id").getStringView();
+    assert(uid == "qqq@u.segito.net");
+    assert((uid.data() >= str.data()) && (uid.data() < str.data() + str.size()));
+
+    auto text = tx.getChild("text").getStringView();
+    assert(text == "line1\nline2");
+    assert((text.data() < str.data()) || (text.data() >= str.data() + str.size()));
+
+    for(auto& p : tx) {
+        assert(p.first.size() > 0);
+    }
+    assert(tx.hasChild("k\"q") != nullptr);
+
+    posdk::Json::Tree copy(tx);
+    assert(copy.getChild("user id").getStringView().data() != uid.data());
+    std::cout << "committing-7:" << posdk::Json::saveToString(copy, 0) << std::endl;
+    return 0;
+}
+
+int test8() {
+    auto etxtext =
+    "{\n"
+    "  \"ChannelID\": \"meghdhoot.segito.net\",\n"
+    "  \"Record\": {\"Reply\": [ {\"value\": \"q\\\\\\\"qq1\\n\"}, 12, -3.5, true, false, null, [] ]}\n"
+    "}";
+
+    posdk::Json::ParseOptions opts;
+    opts.structuralIndex = true;
+    auto t1 = posdk::Json::loadFromString(etxtext);
+    auto t2 = posdk::Json::loadFromString(etxtext, opts);
+    assert(posdk::Json::saveToString(t1) == posdk::Json::saveToString(t2));
+
+    // both modes accept a trailing comma in objects
+    for(auto str : {"{\"a\":1,}", "[1,{\"b\":[true,null],}]", "[ \"a\" , -1.5e3 ]"}) {
+        auto a = posdk::Json::loadFromString(str);
+        auto b = posdk::Json::loadFromString(str, opts);
+        assert(posdk::Json::saveToString(a, 0) == posdk::Json::saveToString(b, 0));
+    }
+
+    // and any nesting depth, without recursing
+    std::string deep = std::string(100000, '[') + std::string(100000, ']');
+    for(auto structural : {false, true}) {
+        posdk::Json::ParseOptions o;
+        o.structuralIndex = structural;
+        auto tx = posdk::Json::loadFromString(deep, o);
+        size_t depth = 1;
+        for(const posdk::Json::Tree* p = &tx; p->size() > 0; p = &p->at(0)) {
+            ++depth;
+        }
+        assert(depth == 100000);
+    }
+#ifdef NDEBUG
+    // and reject tokens that run into the next one. debug builds assert on invalid input
+    for(auto str : {"[truex]", "[1.2.3]", "[\"a\"x]", "{\"a\"x:1}", "[nul l]", "[1,]", "{\"a\":[1 2]}"}) {
+        for(auto structural : {false, true}) {
+            posdk::Json::ParseOptions o;
+            o.structuralIndex = structural;
+            bool thrown = false;
+            try {
+                posdk::Json::loadFromString(str, o);
+            }catch(const posdk::JsonError&) {
+                thrown = true;
+            }
+            assert(thrown);
+        }
+    }
+#endif
+    std::cout << "committing-8:" << posdk::Json::saveToString(t2, 0) << std::endl;
+    return 0;
+}
+
+int test9() {
+    std::string str = "[0, -12, 9223372036854775807, 18446744073709551615, 1e3, -2.5E-2, 36893488147419103232, 0.1]";
+    for(auto structural : {false, true}) {
+        posdk::Json::ParseOptions opts;
+        opts.structuralIndex = structural;
+        auto tx = posdk::Json::loadFromString(str, opts);
+        assert(tx.at(1).getValue<int>() == -12);
+        assert(tx.at(2).getValue<int64_t>() == 9223372036854775807LL);
+        assert(tx.at(3).getValue<uint64_t>() == 18446744073709551615ULL);
+        assert(tx.at(4).getValue<double>() == 1000.0);
+        assert(tx.at(5).getValue<double>() == -0.025);
+        assert(tx.at(6).isValue<double>());
+        assert(tx.at(7).getValue<double>() == 0.1);
+        assert(tx.at(1).getValue<double>() == -12.0);
+
+        bool thrown = false;
+        try {
+            tx.at(1).getValue<uint32_t>();
+        }catch(const posdk::JsonError&) {
+            thrown = true;
+        }
+        assert(thrown);
+    }
+
+    posdk::Json::Tree tx(posdk::Json::DataType::Array);
+    tx.add(posdk::Json::Tree(static_cast<long long>(-1)));
+    tx.add(posdk::Json::Tree(static_cast<unsigned>(7)));
+    tx.add(posdk::Json::Tree(static_cast<uint64_t>(18446744073709551615ULL)));
+    std::cout << "committing-9:" << posdk::Json::saveToString(tx, 0) << std::endl;
+    return 0;
+}
+
+int test10() {
+    struct StringSink : public posdk::Json::Sink {
+        std::string out;
+        size_t writes = 0;
+        inline void write(const char* data, const size_t& size) override {
+            out.append(data, size);
+            ++writes;
+        }
+    };
+
+    StringSink sink;
+    posdk::Json::Writer writer(sink, 0, 16);
+    writer.beginObject();
+    writer.key("id");
+    writer.value(42);
+    writer.key("list");
+    writer.beginArray();
+    for(int i = 0; i < 20; ++i) {
+        writer.value(i);
+    }
+    writer.endArray();
+    writer.key("empty");
+    writer.beginObject();
+    writer.endObject();
+    writer.key("name");
+    writer.value("qqq");
+    writer.endObject();
+    writer.flush();
+    assert(sink.writes > 1);
+    assert(posdk::Json::saveToString(posdk::Json::loadFromString(sink.out), 0) == sink.out);
+
+    posdk::Json::Writer buffered;
+    auto tx = posdk::Json::loadFromString(sink.out);
+    buffered.value(tx);
+    assert(buffered.view() == posdk::Json::saveToString(tx));
+    buffered.clear();
+    buffered.value(tx.getChild("list"));
+    assert(buffered.view() == posdk::Json::saveToString(tx.getChild("list")));
+
+    // saveToString keeps 2 spaces per level for any indent, a Writer takes the spaces per level
+    assert(posdk::Json::saveToString(tx, 4) == posdk::Json::saveToString(tx, 2));
+    assert(posdk::Json::saveToString(tx, 4).find("\n    0") != std::string::npos);
+    posdk::Json::Writer wide(4);
+    wide.value(tx);
+    assert(wide.view().find("\n        0") != std::string::npos);
+    std::cout << "committing-10:" << sink.out << std::endl;
+    return 0;
+}
+
+int test11() {
+    posdk::Json::Tree tx(posdk::Json::DataType::Array);
+    tx.add(posdk::Json::Tree(0.1));
+    tx.add(posdk::Json::Tree(1.0));
+    tx.add(posdk::Json::Tree(12.3f));
+    tx.add(posdk::Json::Tree(1e300));
+    tx.add(posdk::Json::Tree(-2.5e-8));
+    tx.add(posdk::Json::Tree(std::numeric_limits<double>::infinity()));
+    tx.add(posdk::Json::Tree(std::numeric_limits<int64_t>::min()));
+    tx.add(posdk::Json::Tree(static_cast<int64_t>(1000000007)));
+    auto str = posdk::Json::saveToString(tx, 0);
+    assert(str == "[0.1,1.0,12.3,1e+300,-2.5e-08,null,-9223372036854775808,1000000007]");
+
+    // a Tree holds the exact float and writes it in its shortest float form, like the Writer
+    assert(tx.at(2).getValue<double>() == static_cast<double>(12.3f));
+    posdk::Json::Tree copy(tx);
+    assert(posdk::Json::saveToString(copy, 0) == str);
+    posdk::Json::Writer writer(0);
+    writer.beginArray();
+    writer.value(12.3f);
+    writer.value(-0.1f);
+    writer.value(3.0f);
+    writer.endArray();
+    assert(writer.view() == "[12.3,-0.1,3.0]");
+
+    // every double reads back unchanged
+    double d = 1.0 / 3.0;
+    for(int i = 0; i < 1000; ++i) {
+        d = d * 1.37 + static_cast<double>(i);
+        auto t = posdk::Json::loadFromString(posdk::Json::saveToString(posdk::Json::Tree(d), 0));
+        assert(t.getValue<double>() == d);
+    }
+    std::cout << "committing-11:" << str << std::endl;
+    return 0;
+}
+
+int test12() {
+    std::string raw = "q\"b\\s/\b\f\n\r\t";
+    raw += '\x01';
+    raw += "\xc3\xa9 long enough to take the vector path";
+    posdk::Json::Tree tx(posdk::Json::DataType::Object);
+    tx.add(raw, raw);
+    auto str = posdk::Json::saveToString(tx, 0);
+    assert(str.find('\n') == std::string::npos);
+    for(auto structural : {false, true}) {
+        posdk::Json::ParseOptions opts;
+        opts.structuralIndex = structural;
+        auto t = posdk::Json::loadFromString(str, opts);
+        assert(t.get<std::string>(raw) == raw);
+
+        auto u = posdk::Json::loadFromString("[\"\\u00e9\\u20AC\\ud83d\\ude00\\ud800x\\/\"]", opts);
+        assert(u.at(0).getValue<std::string>() == "\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80\xef\xbf\xbdx/");
+    }
+    std::cout << "committing-12:" << str << std::endl;
+    return 0;
+}
+
+int test13() {
+    std::string str = "{\"a\": [1, \"x\\ty\", {\"b\": null}], \"skip\": {\"c\": [true, false]}, \"d\": 2.5}";
+    posdk::Json::Reader reader(str);
+    std::string out;
+    for(auto tok = reader.next(); tok != posdk::Json::Token::End; tok = reader.next()) {
+        switch(tok) {
+            case posdk::Json::Token::BeginObject: out += "{"; break;
+            case posdk::Json::Token::EndObject: out += "}"; break;
+            case posdk::Json::Token::BeginArray: out += "["; break;
+            case posdk::Json::Token::EndArray: out += "]"; break;
+            case posdk::Json::Token::Key:
+                out += std::string(reader.key()) + ":";
+                if(reader.key() == "skip") {
+                    assert(reader.peek() == posdk::Json::Token::BeginObject);
+                    reader.skip();
+                    out += "_";
+                }
+                break;
+            case posdk::Json::Token::Value: out += posdk::Json::saveToString(reader.value(), 0) + " "; break;
+            case posdk::Json::Token::End: break;
+        }
+    }
+    assert(out == "{a:[1 \"x\\ty\" {b:null }]skip:_d:2.5 }");
+
+    posdk::Json::Reader reader2(str);
+    reader2.expect(posdk::Json::Token::BeginObject);
+    reader2.expect(posdk::Json::Token::Key);
+    posdk::Json::Tree tx;
+    reader2.read(tx);
+    assert(posdk::Json::saveToString(tx, 0) == "[1,\"x\\ty\",{\"b\":null}]");
+    assert(reader2.peek() == posdk::Json::Token::Key);
+    std::cout << "committing-13:" << out << std::endl;
+    return 0;
+}
+
+/// \brief replays parse events into a Writer
+struct EchoHandler : public posdk::Json::Handler {
+    posdk::Json::Writer& writer;
+    size_t count = 0;
+    inline EchoHandler(posdk::Json::Writer& w) : writer(w) {}
+    void beginObject() override { writer.beginObject(); }
+    void endObject() override { writer.endObject(); }
+    void beginArray() override { writer.beginArray(); }
+    void endArray() override { writer.endArray(); }
+    void key(const std::string_view& k) override { writer.key(k); }
+    void null() override { writer.null(); ++count; }
+    void value(const posdk::Json::bool_t& v) override { writer.value(v); ++count; }
+    void value(const posdk::Json::integer_t& v) override { writer.value(v); ++count; }
+    void value(const posdk::Json::uinteger_t& v) override { writer.value(v); ++count; }
+    void value(const posdk::Json::float_t& v) override { writer.value(v); ++count; }
+    void value(const std::string_view& v) override { writer.value(v); ++count; }
+};
+
+int test14() {
+    std::string str = "{\"a\": [1, -2, 18446744073709551615, 2.5, \"x\\ny\"], \"b\": {\"c\": null, \"d\": true}, \"e\": []}";
+    std::string expected = posdk::Json::saveToString(posdk::Json::loadFromString(str), 0);
+    for(auto structural : {false, true}) {
+        posdk::Json::ParseOptions opts;
+        opts.structuralIndex = structural;
+        posdk::Json::Writer writer(0);
+        EchoHandler handler(writer);
+        posdk::Json::parse(str, "test14", handler, opts);
+        assert(writer.view() == expected);
+        assert(handler.count == 7);
+    }
+    std::cout << "committing-14:" << expected << std::endl;
+    return 0;
+}
+
+int test15() {
+    std::string str = "{\"a\": [1, 2.5, \"x\\u00e9y\"], \"b\": {\"c\": null, \"d\": true}, \"e\": -12345}";
+    posdk::Json::Tree tree;
+    posdk::Json::PushParser parser(tree);
+    for(size_t i = 0; i < str.size(); ++i) {
+        // each chunk is gone before the next one arrives
+        std::string chunk(1, str[i]);
+        auto status = parser.feed(chunk);
+        assert(status == ((i + 1 < str.size()) ? posdk::Json::PushParser::Status::NeedMore : posdk::Json::PushParser::Status::Complete));
+    }
+    parser.finish();
+    assert(posdk::Json::saveToString(tree, 0) == posdk::Json::saveToString(posdk::Json::loadFromString(str), 0));
+
+    // a number at the top level only ends with the input
+    posdk::Json::Tree num;
+    posdk::Json::PushParser numParser(num);
+    assert(numParser.feed("12") == posdk::Json::PushParser::Status::NeedMore);
+    assert(numParser.feed("34 ") == posdk::Json::PushParser::Status::Complete);
+    numParser.finish();
+    assert(num.getValue<int64_t>() == 1234);
+    std::cout << "committing-15:" << posdk::Json::saveToString(tree, 0) << std::endl;
+    return 0;
+}
+
+int test16() {
+    std::string str = "[{\"a\": [1, \"x,]\"]}, 2, \"s\", [3, [4]], null, {\"b\": {\"c\": true}}, 5.5]";
+    posdk::Json::ParallelOptions popts;
+    popts.threads = 3;
+    popts.chunkSize = 8;
+    posdk::Json::Tree tree;
+    posdk::Json::loadArray(str, "test16", tree, posdk::Json::ParseOptions(), popts);
+    auto expected = posdk::Json::saveToString(posdk::Json::loadFromString(str), 0);
+    assert(tree.size() == 7);
+    assert(posdk::Json::saveToString(tree, 0) == expected);
+
+    // not an array, loaded serially
+    posdk::Json::Tree obj;
+    posdk::Json::loadArray("{\"k\": [1, 2]}", "test16", obj, posdk::Json::ParseOptions(), popts);
+    assert(obj.getChild("k").size() == 2);
+#ifdef NDEBUG
+    // an element load() accepts is accepted by the chunks as well
+    posdk::Json::Tree relaxed;
+    posdk::Json::loadArray("[{\"a\": 1,}, 2]", "test16", relaxed, posdk::Json::ParseOptions(), popts);
+    assert(relaxed.size() == 2);
+#endif
+    std::cout << "committing-16:" << expected << std::endl;
+    return 0;
+}
+
+int test17() {
+    std::string str = "{\"Record\": {\"DocumentID\": \"d1\", \"Items\": [1, {\"a\": \"]}\\\"\"}, [2]]}, \"n\": 5}";
+    posdk::Json::ParseOptions opts;
+    opts.lazy = true;
+    auto tree = posdk::Json::loadFromString(str, opts);
+    assert(!tree.isDeferred());
+    assert(tree.get<int>("n") == 5);
+    auto& rec = tree.getChild("Record");
+    assert(rec.isDeferred());
+    assert(rec.get<std::string>("DocumentID") == "d1");
+    assert(!rec.isDeferred());
+    assert(rec.getChild("Items").isDeferred());
+    assert(rec.getChild("Items").size() == 3);
+
+    // copies expand everything and own their strings
+    posdk::Json::Tree copy(tree);
+    auto expected = "{\"Record\":{\"DocumentID\":\"d1\",\"Items\":[1,{\"a\":\"]}\\\"\"},[2]]},\"n\":5}";
+    assert(posdk::Json::saveToString(copy, 0) == expected);
+    assert(posdk::Json::saveToString(tree, 0) == expected);
+
+    // a const lazy tree can be read from several threads, each container is parsed once
+    const auto shared = posdk::Json::loadFromString(str, opts);
+    std::vector<std::string> out(4);
+    std::vector<std::thread> readers;
+    for(size_t i = 0; i < out.size(); ++i) {
+        readers.emplace_back([&shared, &out, i]() {
+            out[i] = posdk::Json::saveToString(shared, 0);
+        });
+    }
+    for(auto& t : readers) {
+        t.join();
+    }
+    for(auto& o : out) {
+        assert(o == expected);
+    }
+#ifdef NDEBUG
+    // errors found on expansion report the file and the position in the whole input
+    std::string bad = "{\"a\": 1,\n \"b\": [1, 2x]}";
+    posdk::Json::Tree lazy;
+    posdk::Json::load(bad, "test17", lazy, opts);
+    std::string what;
+    try {
+        lazy.getChild("b").size();
+    }catch(const posdk::JsonError& e) {
+        what = e.what();
+    }
+    assert(what.find("test17(2,") != std::string::npos);
+#endif
+    std::cout << "committing-17:" << expected << std::endl;
+    return 0;
+}
+
+int test18() {
+    std::string str = "{\"Record\": {\"DocumentID\": \"d1\", \"Items\": [{\"id\": 7}, {\"a/b\": [true]}]}, \"n\": 5}";
+    auto tree = posdk::Json::loadFromString(str);
+    auto id = posdk::Json::Path::pointer("/Record/DocumentID");
+    auto item = posdk::Json::Path::dotted("Record.Items[0].id");
+    auto escaped = posdk::Json::Path::pointer("/Record/Items/1/a~1b/0");
+    assert(id.get<std::string>(tree) == "d1");
+    assert(item.get<int>(tree) == 7);
+    assert(escaped.get<bool>(tree) == true);
+    assert(posdk::Json::Path::pointer("").find(tree) == &tree);
+    assert(posdk::Json::Path::pointer("/Record/Items/2").find(tree) == nullptr);
+    assert(posdk::Json::Path::dotted("n.x").find(tree) == nullptr);
+
+    // the same paths over parse events, without building the document
+    posdk::Json::PathSelector selector({id, item, escaped, posdk::Json::Path::pointer("/Record/Items")});
+    posdk::Json::parse(str, "test18", selector);
+    assert(selector.result(0)->getValue<std::string>() == "d1");
+    assert(selector.result(1)->getValue<int>() == 7);
+    assert(selector.result(2)->getValue<bool>() == true);
+    auto items = posdk::Json::saveToString(*selector.result(3), 0);
+    assert(items == posdk::Json::saveToString(tree.getChild("Record").getChild("Items"), 0));
+
+    // results are cleared by the next document
+    posdk::Json::parse("{\"n\": 1}", "test18", selector);
+    assert(selector.result(0) == nullptr);
+    std::cout << "committing-18:" << items << std::endl;
+    return 0;
+}
+
+int test19() {
+    auto tree = posdk::Json::loadFromString("{\"a\": 1, \"b\": [-1, 1.5, true, null, \"IETF\"]}");
+    auto cbor = posdk::Json::saveToString(tree, posdk::Json::Encoding::Cbor);
+    // indefinite length map and array, then RFC 8949 appendix A encodings
+    assert(cbor == std::string("\xbf\x61" "a" "\x01\x61" "b" "\x9f\x20\xfa\x3f\xc0\x00\x00\xf5\xf6\x64" "IETF" "\xff\xff", 22));
+
+    posdk::Json::ParseOptions opts;
+    opts.encoding = posdk::Json::Encoding::Cbor;
+    auto back = posdk::Json::loadFromString(cbor, opts);
+    assert(posdk::Json::saveToString(back, 0) == posdk::Json::saveToString(tree, 0));
+
+    // definite lengths, a half float and a tag as other encoders write them
+    auto other = posdk::Json::loadFromString(std::string("\xa2\x61" "a" "\xf9\x3e\x00\x61" "b" "\xc1\x1a\x51\x4b\x67\xb0", 14), opts);
+    assert(other.get<double>("a") == 1.5);
+    assert(other.get<int64_t>("b") == 1363896240);
+
+    posdk::Json::Reader reader(cbor, "test19", opts);
+    assert(reader.next() == posdk::Json::Token::BeginObject);
+    assert(reader.next() == posdk::Json::Token::Key);
+    assert(reader.key() == "a");
+    assert(reader.next() == posdk::Json::Token::Value);
+    assert(reader.value().getValue<int>() == 1);
+    assert(reader.next() == posdk::Json::Token::Key);
+    reader.skip();
+    assert(reader.next() == posdk::Json::Token::EndObject);
+    assert(reader.next() == posdk::Json::Token::End);
+    std::cout << "committing-19:" << posdk::Json::saveToString(back, 0) << std::endl;
+    return 0;
+}
+
 int main(int argc, char* argv[]) {
     test1();
     test2();
     test3();
+    test4();
+    test5();
+    test6();
+    test7();
+    test8();
+    test9();
+    test10();
+    test11();
+    test12();
+    test13();
+    test14();
+    test15();
+    test16();
+    test17();
+    test18();
+    test19();
     return 0;
 }
@@ -1,6 +1,35 @@
 #include "jaser/Json.hpp"
 #include <fstream>
+#include <iterator>
 #include <assert.h>
+#include <charconv>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <array>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cmath>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define HAVE_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+// AVX2 is compiled per function and picked at runtime, SSE2 only when the
+// build targets it, which 32 bit x86 builds do not by default
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define HAVE_AVX2
+#ifdef __SSE2__
+#define HAVE_SSE2
+#endif
+#include <immintrin.h>
+#endif
 
 #ifndef NDEBUG
 #define DO_ASSERT
@@ -13,14 +42,91 @@
 #endif
 
 namespace {
+    /// \brief true for bytes that end a plain run inside a string: quote, backslash, control chars
+    inline bool isStringSpecial(const char& ch) {
+        return ((ch == '"') || (ch == '\\') || (static_cast<unsigned char>(ch) < 0x20));
+    }
+
+    inline const char* scanStringScalar(const char* p, const char* end) {
+        while((p < end) && !isStringSpecial(*p)) {
+            ++p;
+        }
+        return p;
+    }
+
+#ifdef HAVE_SSE2
+    inline const char* scanStringSse2(const char* p, const char* end) {
+        const __m128i quote = _mm_set1_epi8('"');
+        const __m128i bslash = _mm_set1_epi8('\\');
+        const __m128i ctl = _mm_set1_epi8(0x1f);
+        while((end - p) >= 16) {
+            auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            auto m = _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, bslash));
+            // unsigned v <= 0x1f
+            m = _mm_or_si128(m, _mm_cmpeq_epi8(_mm_min_epu8(v, ctl), v));
+            auto mask = _mm_movemask_epi8(m);
+            if(mask != 0) {
+                return p + __builtin_ctz(static_cast<unsigned>(mask));
+            }
+            p += 16;
+        }
+        return scanStringScalar(p, end);
+    }
+#endif
+
+#ifdef HAVE_AVX2
+    __attribute__((target("avx2")))
+    const char* scanStringAvx2(const char* p, const char* end) {
+        const __m256i quote = _mm256_set1_epi8('"');
+        const __m256i bslash = _mm256_set1_epi8('\\');
+        const __m256i ctl = _mm256_set1_epi8(0x1f);
+        while((end - p) >= 32) {
+            auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+            auto m = _mm256_or_si256(_mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, bslash));
+            m = _mm256_or_si256(m, _mm256_cmpeq_epi8(_mm256_min_epu8(v, ctl), v));
+            auto mask = static_cast<unsigned>(_mm256_movemask_epi8(m));
+            if(mask != 0) {
+                return p + __builtin_ctz(mask);
+            }
+            p += 32;
+        }
+#ifdef HAVE_SSE2
+        return scanStringSse2(p, end);
+#else
+        return scanStringScalar(p, end);
+#endif
+    }
+#endif
+
+    typedef const char* (*ScanFn)(const char* p, const char* end);
+
+    /// \brief pick the widest string scanner this cpu supports, once
+    inline ScanFn selectScanString() {
+#ifdef HAVE_AVX2
+        if(__builtin_cpu_supports("avx2")) {
+            return scanStringAvx2;
+        }
+#endif
+#ifdef HAVE_SSE2
+        return scanStringSse2;
+#else
+        return scanStringScalar;
+#endif
+    }
+
+    /// \brief first quote, backslash or control char in [p, end), or end
+    inline const char* scanString(const char* p, const char* end) {
+        static const ScanFn fn = selectScanString();
+        return fn(p, end);
+    }
+
     enum class ParserState {
         EnterValue,
-        EnterNumber0,
-        EnterNumber1,
         EnterString,
         EnterStringEscape,
         EnterObjectKey,
         EnterObjectKeyString,
+        EnterObjectKeyStringEscape,
         LeaveObjectKeyString,
         LeaveObjectValue,
         EnterArray0,
@@ -37,529 +143,3478 @@ namespace {
         TokenNull_nul,
     };
 
+    /// \brief true while inside a string or key, where whitespace is content
+    inline bool inString(const ParserState& s) {
+        switch(s) {
+            case ParserState::EnterString:
+            case ParserState::EnterStringEscape:
+            case ParserState::EnterObjectKeyString:
+            case ParserState::EnterObjectKeyStringEscape:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    /// \brief true in the middle of true, false or null, which cannot contain whitespace
+    inline bool inLiteral(const ParserState& s) {
+        return (s >= ParserState::TokenTrue_t);
+    }
+
+    /// \brief walks a contiguous input buffer
+    /// row/col are only needed for error messages, so they are derived
+    /// from the current offset on demand instead of being tracked per byte
     struct Tokeniser {
-        std::istream& in_;
+        const char* begin_;
+        const char* end_;
+        const char* cur_;
         const std::string& name_;
-        size_t row = 1;
-        size_t col = 1;
-        char ch_;
+        const posdk::Json::ParseOptions& opts_;
+        /// \brief true if more input may follow end_, see PushParser
+        bool partial_ = false;
+        /// \brief position of begin_ in the whole input
+        size_t row0_ = 1;
+        size_t col0_ = 1;
 
         inline std::string pos() const {
+            size_t row = row0_;
+            size_t col = col0_;
+            for(auto p = begin_; p < cur_; ++p) {
+                col++;
+                if(*p == '\n') {
+                    row++;
+                    col = 1;
+                }
+            }
             std::ostringstream os;
             os << name_ << "(" << row << "," << col << ")";
             return os.str();
         }
 
-        inline char eof() {
-            return in_.eof();
+        inline bool eof() const {
+            return (cur_ == end_);
+        }
+
+        inline char peek() const {
+            ASSERT(cur_ < end_);
+            return *cur_;
         }
 
-        inline char peek_() {
-            auto ch = static_cast<char>(in_.peek());
-            return ch;
+        inline void next() {
+            ASSERT(cur_ < end_);
+            ++cur_;
         }
 
-        inline char peek() {
-            ch_ = peek_();
-            return ch_;
+        /// \brief skip ahead to p, which must not be past the end
+        inline void skipTo(const char* p) {
+            ASSERT((cur_ <= p) && (p <= end_));
+            cur_ = p;
         }
 
-        inline void next() {
-            if(ch_ != peek_()) {
-                ASSERT(false);
-                throw posdk::JsonError("{0}: internal error in json", pos());
+        inline Tokeniser(const char* begin, const char* end, const std::string& name, const posdk::Json::ParseOptions& opts) : begin_(begin), end_(end), cur_(begin), name_(name), opts_(opts) {}
+    };
+
+    /// \brief a string or key being scanned
+    /// while no escape has been seen the string is just the input range from begin_,
+    /// the first escape copies that range into buf_ and decoding continues there
+    struct StringRun {
+        const char* begin_ = nullptr;
+        bool escaped_ = false;
+        std::string buf_;
+
+        inline void start(const char* cur) {
+            begin_ = cur;
+            escaped_ = false;
+            buf_.clear();
+        }
+
+        inline void escape(const char* cur) {
+            if(!escaped_) {
+                buf_.assign(begin_, cur);
+                escaped_ = true;
+            }
+        }
+
+        inline void append(const char* begin, const char* end) {
+            if(escaped_) {
+                buf_.append(begin, end);
+            }
+        }
+
+        /// \brief the code unit in the 4 hex digits at p, false if there are none
+        static inline bool hex4(const char* p, const char* end, uint32_t& cu) {
+            if((end - p) < 4) {
+                return false;
+            }
+            cu = 0;
+            for(auto e = p + 4; p < e; ++p) {
+                cu <<= 4;
+                if((*p >= '0') && (*p <= '9')) {
+                    cu |= static_cast<uint32_t>(*p - '0');
+                }else if((*p >= 'a') && (*p <= 'f')) {
+                    cu |= static_cast<uint32_t>(*p - 'a' + 10);
+                }else if((*p >= 'A') && (*p <= 'F')) {
+                    cu |= static_cast<uint32_t>(*p - 'A' + 10);
+                }else{
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        inline void appendUtf8(const uint32_t& cp) {
+            if(cp < 0x80) {
+                buf_ += static_cast<char>(cp);
+            }else if(cp < 0x800) {
+                buf_ += static_cast<char>(0xc0 | (cp >> 6));
+                buf_ += static_cast<char>(0x80 | (cp & 0x3f));
+            }else if(cp < 0x10000) {
+                buf_ += static_cast<char>(0xe0 | (cp >> 12));
+                buf_ += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+                buf_ += static_cast<char>(0x80 | (cp & 0x3f));
+            }else{
+                buf_ += static_cast<char>(0xf0 | (cp >> 18));
+                buf_ += static_cast<char>(0x80 | ((cp >> 12) & 0x3f));
+                buf_ += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+                buf_ += static_cast<char>(0x80 | (cp & 0x3f));
+            }
+        }
+
+        /// \brief decode the escape following a backslash, in is on the char after it
+        /// \uXXXX is written as UTF-8, a surrogate pair as one code point and
+        /// an unpaired surrogate as U+FFFD
+        inline void unescape(Tokeniser& in) {
+            auto ch = in.peek();
+            in.next();
+            switch(ch) {
+                case '"':
+                case '\\':
+                case '/':
+                    buf_ += ch;
+                    break;
+                case 'b':
+                    buf_ += '\b';
+                    break;
+                case 'f':
+                    buf_ += '\f';
+                    break;
+                case 'n':
+                    buf_ += '\n';
+                    break;
+                case 'r':
+                    buf_ += '\r';
+                    break;
+                case 't':
+                    buf_ += '\t';
+                    break;
+                case 'u': {
+                    uint32_t cp = 0;
+                    if(!hex4(in.cur_, in.end_, cp)) {
+                        ASSERT(false);
+                        throw posdk::JsonError("{0}: invalid unicode escape in json", in.pos());
+                    }
+                    in.skipTo(in.cur_ + 4);
+                    if((cp >= 0xd800) && (cp < 0xdc00)) {
+                        auto p = in.cur_;
+                        uint32_t lo = 0;
+                        if(((in.end_ - p) >= 6) && (p[0] == '\\') && (p[1] == 'u') && hex4(p + 2, in.end_, lo) && (lo >= 0xdc00) && (lo < 0xe000)) {
+                            cp = 0x10000 + ((cp - 0xd800) << 10) + (lo - 0xdc00);
+                            in.skipTo(p + 6);
+                        }else{
+                            cp = 0xfffd;
+                        }
+                    }else if((cp >= 0xdc00) && (cp < 0xe000)) {
+                        cp = 0xfffd;
+                    }
+                    appendUtf8(cp);
+                    break;
+                }
+                default:
+                    ASSERT(false);
+                    throw posdk::JsonError("{0}: invalid escape in json", in.pos());
             }
+        }
 
-            in_.get();
-            col++;
-            if(ch_ == '\n') {
-                row++;
-                col = 1;
+        /// \brief the scanned string, cur is the position of the closing quote
+        inline std::string_view view(const char* cur) const {
+            if(escaped_) {
+                return std::string_view(buf_);
             }
+            return std::string_view(begin_, static_cast<size_t>(cur - begin_));
         }
 
-        inline Tokeniser(std::istream& in, const std::string& name) : in_(in), name_(name) {}
+        /// \brief true if view() points into the input buffer
+        inline bool borrowable() const {
+            return !escaped_;
+        }
     };
 
-    void parseValue(Tokeniser& in, posdk::Json::Tree& tree) {
-        auto s = ParserState::EnterValue;
-        std::string n;
-        std::string k;
-        while(!in.eof()) {
-            char ch = in.peek();
-            // std::cout << in.pos() << ":" << ch << ":" << static_cast<int>(ch) << ":" << static_cast<int>(s) << std::endl;
-
-            if(s != ParserState::EnterString){
-                switch(ch) {
-                    case 0:
-                    case ' ':
-                    case '\t':
-                    case '\r':
-                    case '\n':
-                        in.next();
-                        continue;
+    /// \brief string whose opening quote is at the tokeniser position, which is
+    /// left after the closing quote
+    std::string_view readQuoted(Tokeniser& in, StringRun& run) {
+        in.next();
+        run.start(in.cur_);
+        for(;;) {
+            auto e = scanString(in.cur_, in.end_);
+            run.append(in.cur_, e);
+            in.skipTo(e);
+            if(in.eof()) {
+                ASSERT(false);
+                throw posdk::JsonError("{0}: unexpected EOF in json", in.pos());
+            }
+            auto ch = in.peek();
+            if(ch == '"') {
+                auto v = run.view(in.cur_);
+                in.next();
+                return v;
+            }
+            if(ch == '\\') {
+                run.escape(in.cur_);
+                in.next();
+                if(in.eof()) {
+                    ASSERT(false);
+                    throw posdk::JsonError("{0}: unexpected EOF in json", in.pos());
+                }
+                run.unescape(in);
+                continue;
+            }
+            // raw control char, kept as is
+            run.append(in.cur_, in.cur_ + 1);
+            in.next();
+        }
+    }
+
+    static const char DigitPairs[] =
+        "00010203040506070809"
+        "10111213141516171819"
+        "20212223242526272829"
+        "30313233343536373839"
+        "40414243444546474849"
+        "50515253545556575859"
+        "60616263646566676869"
+        "70717273747576777879"
+        "80818283848586878889"
+        "90919293949596979899";
+
+    /// \brief writes val right-aligned ending at end, two digits per step, returns the first char
+    inline char* formatUnsigned(uint64_t val, char* end) {
+        while(val >= 100) {
+            auto i = (val % 100) * 2;
+            val /= 100;
+            end -= 2;
+            end[0] = DigitPairs[i];
+            end[1] = DigitPairs[i + 1];
+        }
+        if(val >= 10) {
+            end -= 2;
+            end[0] = DigitPairs[val * 2];
+            end[1] = DigitPairs[(val * 2) + 1];
+        }else{
+            *--end = static_cast<char>('0' + val);
+        }
+        return end;
+    }
+
+    inline bool isDigit(const char& ch) {
+        return ((ch >= '0') && (ch <= '9'));
+    }
+
+    inline bool isSpace(const char& ch) {
+        return ((ch == ' ') || (ch == '\t') || (ch == '\r') || (ch == '\n') || (ch == 0));
+    }
+
+    /// \brief converts [begin, end) to a double, which must be a valid number
+    inline double toDouble(const char* begin, const char* end) {
+        double val = 0;
+#ifdef __cpp_lib_to_chars
+        auto r = std::from_chars(begin, end, val);
+        if(r.ec == std::errc()) {
+            return val;
+        }
+#endif
+        // out of range (or no from_chars): strtod gives +-inf or 0 like the spec suggests
+        std::string n(begin, end);
+        return std::strtod(n.c_str(), nullptr);
+    }
+
+    /// \brief parses the number at the tokeniser position and reports it to handler
+    /// integers are reported as integer_t, or uinteger_t above INT64_MAX, and
+    /// anything with a fraction or exponent, or too large for either, as float_t
+    /// a leading '+' is accepted for compatibility with older files
+    /// returns false, leaving the position on the number, if a partial input ends inside it
+    template <typename HandlerT>
+    bool parseNumber(Tokeniser& in, HandlerT& handler) {
+        auto p = in.cur_;
+        auto e = in.end_;
+        if((p < e) && (*p == '+')) {
+            ++p;
+        }
+        auto begin = p;
+        if((p < e) && (*p == '-')) {
+            ++p;
+        }
+        auto digits = p;
+        while((p < e) && isDigit(*p)) {
+            ++p;
+        }
+        if(in.partial_ && (p == e)) {
+            return false;
+        }
+        if(p == digits) {
+            ASSERT(false);
+            throw posdk::JsonError("{0}: invalid number in json", in.pos());
+        }
+        bool isFloat = false;
+        if((p < e) && (*p == '.')) {
+            isFloat = true;
+            ++p;
+            while((p < e) && isDigit(*p)) {
+                ++p;
+            }
+            if(in.partial_ && (p == e)) {
+                return false;
+            }
+        }
+        if((p < e) && ((*p == 'e') || (*p == 'E'))) {
+            isFloat = true;
+            ++p;
+            if((p < e) && ((*p == '-') || (*p == '+'))) {
+                ++p;
+            }
+            auto exp = p;
+            while((p < e) && isDigit(*p)) {
+                ++p;
+            }
+            if(in.partial_ && (p == e)) {
+                return false;
+            }
+            if(p == exp) {
+                in.skipTo(p);
+                ASSERT(false);
+                throw posdk::JsonError("{0}: invalid number in json", in.pos());
+            }
+        }
+
+        if(!isFloat) {
+            int64_t ival = 0;
+            auto r = std::from_chars(begin, p, ival);
+            if(r.ec == std::errc()) {
+                handler.value(ival);
+                in.skipTo(p);
+                return true;
+            }
+            if(begin == digits) {
+                uint64_t uval = 0;
+                r = std::from_chars(begin, p, uval);
+                if(r.ec == std::errc()) {
+                    handler.value(uval);
+                    in.skipTo(p);
+                    return true;
                 }
             }
+        }
+        handler.value(toDouble(begin, p));
+        in.skipTo(p);
+        return true;
+    }
+
+    /// \brief true if the escape at p, a backslash, is complete in [p, end)
+    /// a high surrogate also waits for the \u that may pair with it
+    inline bool escapeComplete(const char* p, const char* end) {
+        auto n = end - p;
+        if(n < 2) {
+            return false;
+        }
+        if(p[1] != 'u') {
+            return true;
+        }
+        uint32_t cp = 0;
+        if(n < 6) {
+            return false;
+        }
+        if(!StringRun::hex4(p + 2, end, cp) || (cp < 0xd800) || (cp >= 0xdc00)) {
+            return true;
+        }
+        if((n > 6) && (p[6] != '\\')) {
+            return true;
+        }
+        if((n > 7) && (p[7] != 'u')) {
+            return true;
+        }
+        return (n >= 12);
+    }
+
+    /// \brief parses one value and reports it to handler
+    /// nesting is kept on stack_ instead of the call stack, so the parser can stop
+    /// at the end of a partial input and carry on when run() is called with more.
+    /// it stops either after the last byte, with any open string copied out of the
+    /// input, or on the first byte of a number or escape that may continue.
+    /// HandlerT has the members of Json::Handler, with an extra borrowable flag on
+    /// key() and string value(), true if the view points into the input buffer
+    template <typename HandlerT>
+    struct ValueParser {
+        HandlerT& handler_;
+        ParserState s_ = ParserState::EnterValue;
+        std::vector<char> stack_;
+        StringRun str_;
+        StringRun key_;
+
+        inline ValueParser(HandlerT& handler) : handler_(handler) {}
+
+        /// \brief state after a value, true if it was the outermost one
+        inline bool endValue() {
+            if(stack_.empty()) {
+                return true;
+            }
+            s_ = (stack_.back() == '[') ? ParserState::EnterArray1 : ParserState::LeaveObjectValue;
+            return false;
+        }
+
+        /// \brief true once the value is complete, the tokeniser is left after it
+        /// false if a partial input ran out first, EOF in a complete input throws
+        bool run(Tokeniser& in) {
+            while(!in.eof()) {
+                char ch = in.peek();
 
-            posdk::Json::Tree j(posdk::Json::DataType::Value);
-            switch(s) {
-                case ParserState::EnterValue:
+                if(!inString(s_) && !inLiteral(s_)){
                     switch(ch) {
-                        case '{':
+                        case 0:
+                        case ' ':
+                        case '\t':
+                        case '\r':
+                        case '\n':
                             in.next();
-                            s = ParserState::EnterObjectKey;
-                            tree = posdk::Json::Tree(posdk::Json::DataType::Object);
-                            break;
+                            continue;
+                    }
+                }
+
+                switch(s_) {
+                    case ParserState::EnterValue:
+                        switch(ch) {
+                            case '{':
+                                in.next();
+                                stack_.push_back('{');
+                                s_ = ParserState::EnterObjectKey;
+                                handler_.beginObject();
+                                break;
+
+                            case '[':
+                                in.next();
+                                stack_.push_back('[');
+                                s_ = ParserState::EnterArray0;
+                                handler_.beginArray();
+                                break;
+
+                            case 't':
+                                in.next();
+                                s_ = ParserState::TokenTrue_t;
+                                break;
+
+                            case 'f':
+                                in.next();
+                                s_ = ParserState::TokenFalse_f;
+                                break;
+
+                            case 'n':
+                                in.next();
+                                s_ = ParserState::TokenNull_n;
+                                break;
+
+                            case '-':
+                            case '+':
+                            case '0':
+                            case '1':
+                            case '2':
+                            case '3':
+                            case '4':
+                            case '5':
+                            case '6':
+                            case '7':
+                            case '8':
+                            case '9':
+                                if(!parseNumber(in, handler_)) {
+                                    return false;
+                                }
+                                if(endValue()) {
+                                    return true;
+                                }
+                                break;
+
+                            case '"':
+                                in.next();
+                                str_.start(in.cur_);
+                                s_ = ParserState::EnterString;
+                                break;
+
+                            default:
+                                ASSERT(false);
+                                throw posdk::JsonError("{0}: invalid char in json", in.pos());
+                        }
+                        break;
+
+                    case ParserState::EnterString:
+                        switch(ch) {
+                            case '"':
+                                handler_.value(str_.view(in.cur_), str_.borrowable());
+                                in.next();
+                                if(endValue()) {
+                                    return true;
+                                }
+                                break;
+
+                            case '\\':
+                                str_.escape(in.cur_);
+                                if(in.partial_ && !escapeComplete(in.cur_, in.end_)) {
+                                    return false;
+                                }
+                                in.next();
+                                s_ = ParserState::EnterStringEscape;
+                                break;
+
+                            default: {
+                                // add the run up to the next quote, backslash or control char
+                                auto e = scanString(in.cur_ + 1, in.end_);
+                                str_.append(in.cur_, e);
+                                in.skipTo(e);
+                                break;
+                            }
+                        }
+                        break;
+
+                    case ParserState::EnterStringEscape:
+                        str_.unescape(in);
+                        s_ = ParserState::EnterString;
+                        break;
+
+                    case ParserState::EnterArray0:
+                        switch(ch) {
+                            case ']':
+                                in.next();
+                                stack_.pop_back();
+                                handler_.endArray();
+                                if(endValue()) {
+                                    return true;
+                                }
+                                break;
+
+                            default:
+                                s_ = ParserState::EnterValue;
+                                break;
+                        }
+                        break;
+                    case ParserState::EnterArray1:
+                        switch(ch) {
+                            case ',':
+                                in.next();
+                                s_ = ParserState::EnterValue;
+                                break;
+
+                            case ']':
+                                in.next();
+                                stack_.pop_back();
+                                handler_.endArray();
+                                if(endValue()) {
+                                    return true;
+                                }
+                                break;
+
+                            default:
+                                ASSERT(false);
+                                throw posdk::JsonError("{0}: invalid char in json", in.pos());
+                        }
+                        break;
+
+                    case ParserState::EnterObjectKey:
+                        switch(ch) {
+                            case '"':
+                                in.next();
+                                key_.start(in.cur_);
+                                s_ = ParserState::EnterObjectKeyString;
+                                break;
+
+                            case '}':
+                                in.next();
+                                stack_.pop_back();
+                                handler_.endObject();
+                                if(endValue()) {
+                                    return true;
+                                }
+                                break;
 
-                        case '[':
+                            default:
+                                ASSERT(false);
+                                throw posdk::JsonError("{0}: invalid char in json", in.pos());
+                        }
+                        break;
+
+                    case ParserState::EnterObjectKeyString:
+                        switch(ch) {
+                            case '"':
+                                if(in.partial_) {
+                                    // the value may arrive after this input is gone
+                                    key_.escape(in.cur_);
+                                }
+                                handler_.key(key_.view(in.cur_), key_.borrowable());
+                                in.next();
+                                s_ = ParserState::LeaveObjectKeyString;
+                                break;
+
+                            case '\\':
+                                key_.escape(in.cur_);
+                                if(in.partial_ && !escapeComplete(in.cur_, in.end_)) {
+                                    return false;
+                                }
+                                in.next();
+                                s_ = ParserState::EnterObjectKeyStringEscape;
+                                break;
+
+                            default: {
+                                // add the run up to the next quote, backslash or control char
+                                auto e = scanString(in.cur_ + 1, in.end_);
+                                key_.append(in.cur_, e);
+                                in.skipTo(e);
+                                break;
+                            }
+                        }
+                        break;
+
+                    case ParserState::EnterObjectKeyStringEscape:
+                        key_.unescape(in);
+                        s_ = ParserState::EnterObjectKeyString;
+                        break;
+
+                    case ParserState::LeaveObjectKeyString:
+                        switch(ch) {
+                            case ':':
+                                in.next();
+                                s_ = ParserState::EnterValue;
+                                break;
+
+                            default:
+                                ASSERT(false);
+                                throw posdk::JsonError("{0}: invalid char in json", in.pos());
+                        }
+                        break;
+
+                    case ParserState::LeaveObjectValue:
+                        switch(ch) {
+                            case '}':
+                                in.next();
+                                stack_.pop_back();
+                                handler_.endObject();
+                                if(endValue()) {
+                                    return true;
+                                }
+                                break;
+
+                            case ',':
+                                in.next();
+                                s_ = ParserState::EnterObjectKey;
+                                break;
+
+                            default:
+                                ASSERT(false);
+                                throw posdk::JsonError("{0}: invalid char in json", in.pos());
+                        }
+                        break;
+                    case ParserState::TokenTrue_t:
+                        if(ch == 'r'){
                             in.next();
-                            s = ParserState::EnterArray0;
-                            tree = posdk::Json::Tree(posdk::Json::DataType::Array);
+                            s_ = ParserState::TokenTrue_tr;
                             break;
-
-                        case 't':
+                        }
+                        ASSERT(false);
+                        throw posdk::JsonError("{0}: invalid char in json", in.pos());
+                    case ParserState::TokenTrue_tr:
+                        if(ch == 'u'){
                             in.next();
-                            s = ParserState::TokenTrue_t;
+                            s_ = ParserState::TokenTrue_tru;
                             break;
-
-                        case 'f':
+                        }
+                        ASSERT(false);
+                        throw posdk::JsonError("{0}: invalid char in json", in.pos());
+                    case ParserState::TokenTrue_tru:
+                        if(ch == 'e'){
                             in.next();
-                            s = ParserState::TokenFalse_f;
+                            handler_.value(true);
+                            if(endValue()) {
+                                return true;
+                            }
                             break;
-
-                        case 'n':
+                        }
+                        ASSERT(false);
+                        throw posdk::JsonError("{0}: invalid char in json", in.pos());
+                    case ParserState::TokenFalse_f:
+                        if(ch == 'a'){
                             in.next();
-                            s = ParserState::TokenNull_n;
+                            s_ = ParserState::TokenFalse_fa;
                             break;
-
-                        case '-':
-                        case '+':
-                        case '0':
-                        case '1':
-                        case '2':
-                        case '3':
-                        case '4':
-                        case '5':
-                        case '6':
-                        case '7':
-                        case '8':
-                        case '9':
-                            // add to number
-                            n += ch;
+                        }
+                        ASSERT(false);
+                        throw posdk::JsonError("{0}: invalid char in json", in.pos());
+                    case ParserState::TokenFalse_fa:
+                        if(ch == 'l'){
                             in.next();
-                            s = ParserState::EnterNumber0;
+                            s_ = ParserState::TokenFalse_fal;
                             break;
-
-                        case '"':
+                        }
+                        ASSERT(false);
+                        throw posdk::JsonError("{0}: invalid char in json", in.pos());
+                    case ParserState::TokenFalse_fal:
+                        if(ch == 's'){
+                            in.next();
+                            s_ = ParserState::TokenFalse_fals;
+                            break;
+                        }
+                        ASSERT(false);
+                        throw posdk::JsonError("{0}: invalid char in json", in.pos());
+                    case ParserState::TokenFalse_fals:
+                        if(ch == 'e'){
+                            in.next();
+                            handler_.value(false);
+                            if(endValue()) {
+                                return true;
+                            }
+                            break;
+                        }
+                        ASSERT(false);
+                        throw posdk::JsonError("{0}: invalid char in json", in.pos());
+                    case ParserState::TokenNull_n:
+                        if(ch == 'u'){
+                            in.next();
+                            s_ = ParserState::TokenNull_nu;
+                            break;
+                        }
+                        ASSERT(false);
+                        throw posdk::JsonError("{0}: invalid char in json", in.pos());
+                    case ParserState::TokenNull_nu:
+                        if(ch == 'l'){
+                            in.next();
+                            s_ = ParserState::TokenNull_nul;
+                            break;
+                        }
+                        ASSERT(false);
+                        throw posdk::JsonError("{0}: invalid char in json", in.pos());
+                    case ParserState::TokenNull_nul:
+                        if(ch == 'l'){
                             in.next();
-                            s = ParserState::EnterString;
+                            handler_.null();
+                            if(endValue()) {
+                                return true;
+                            }
                             break;
+                        }
+                        ASSERT(false);
+                        throw posdk::JsonError("{0}: invalid char in json", in.pos());
+                }
+            }
 
-                        default:
-                            ASSERT(false);
-                            throw posdk::JsonError("{0}: invalid char in json", in.pos());
-                    }
+            if(!in.partial_) {
+                ASSERT(false);
+                throw posdk::JsonError("{0}: unexpected EOF in json", in.pos());
+            }
+            // an open string is copied out, the input may be gone by the next run()
+            if(s_ == ParserState::EnterString) {
+                str_.escape(in.cur_);
+            }else if(s_ == ParserState::EnterObjectKeyString) {
+                key_.escape(in.cur_);
+            }
+            return false;
+        }
+    };
+
+    /// \brief parse one complete value at the tokeniser position and report it to handler
+    template <typename HandlerT>
+    inline void parseValue(Tokeniser& in, HandlerT& handler) {
+        ValueParser<HandlerT> parser(handler);
+        parser.run(in);
+    }
+
+    /// \brief throws unless only whitespace is left after a value
+    inline void expectEnd(Tokeniser& in) {
+        while(!in.eof()) {
+            switch(in.peek()) {
+                case 0:
+                case ' ':
+                case '\t':
+                case '\r':
+                case '\n':
+                    in.next();
+                    continue;
+            }
+            ASSERT(false);
+            throw posdk::JsonError("{0}: unexpected data after json", in.pos());
+        }
+    }
+
+    /// \brief per-block byte classes used by the structural index
+    struct BlockMasks {
+        uint64_t quote;
+        uint64_t backslash;
+        uint64_t op;
+        uint64_t space;
+    };
+
+    inline void classifyScalar(const char* p, BlockMasks& m) {
+        m = BlockMasks{0, 0, 0, 0};
+        for(size_t i = 0; i < 64; ++i) {
+            auto bit = (static_cast<uint64_t>(1) << i);
+            switch(p[i]) {
+                case '"':
+                    m.quote |= bit;
                     break;
+                case '\\':
+                    m.backslash |= bit;
+                    break;
+                case '{':
+                case '}':
+                case '[':
+                case ']':
+                case ':':
+                case ',':
+                    m.op |= bit;
+                    break;
+                case 0:
+                case ' ':
+                case '\t':
+                case '\r':
+                case '\n':
+                    m.space |= bit;
+                    break;
+            }
+        }
+    }
 
-                case ParserState::EnterNumber0:
-                    switch(ch) {
-                        case '0':
-                        case '1':
-                        case '2':
-                        case '3':
-                        case '4':
-                        case '5':
-                        case '6':
-                        case '7':
-                        case '8':
-                        case '9':
-                            // add to number
-                            n += ch;
-                            in.next();
-                            break;
+#ifdef HAVE_SSE2
+    inline void classifySse2(const char* p, BlockMasks& m) {
+        m = BlockMasks{0, 0, 0, 0};
+        for(size_t i = 0; i < 4; ++i) {
+            auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i * 16));
+            auto eq = [&v](const char& ch) {
+                return _mm_cmpeq_epi8(v, _mm_set1_epi8(ch));
+            };
+            auto bits = [](const __m128i& x) {
+                return static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(x)));
+            };
+            auto op = _mm_or_si128(_mm_or_si128(_mm_or_si128(eq('{'), eq('}')), _mm_or_si128(eq('['), eq(']'))), _mm_or_si128(eq(':'), eq(',')));
+            auto sp = _mm_or_si128(_mm_or_si128(_mm_or_si128(eq(' '), eq('\t')), _mm_or_si128(eq('\r'), eq('\n'))), eq(0));
+            m.quote |= bits(eq('"')) << (i * 16);
+            m.backslash |= bits(eq('\\')) << (i * 16);
+            m.op |= bits(op) << (i * 16);
+            m.space |= bits(sp) << (i * 16);
+        }
+    }
+#endif
+
+    inline void classify(const char* p, BlockMasks& m) {
+#ifdef HAVE_SSE2
+        classifySse2(p, m);
+#else
+        classifyScalar(p, m);
+#endif
+    }
+
+    /// \brief index of the lowest set bit, x must not be 0
+    inline size_t lowestBit(const uint64_t& x) {
+#ifdef __GNUC__
+        return static_cast<size_t>(__builtin_ctzll(x));
+#else
+        // de Bruijn multiplication on the isolated bit
+        static const uint8_t table[64] = {
+            0, 1, 48, 2, 57, 49, 28, 3, 61, 58, 50, 42, 38, 29, 17, 4,
+            62, 55, 59, 36, 53, 51, 43, 22, 45, 39, 33, 30, 24, 18, 12, 5,
+            63, 47, 56, 27, 60, 41, 37, 16, 54, 35, 52, 21, 44, 32, 23, 11,
+            46, 26, 40, 15, 34, 20, 31, 10, 25, 14, 19, 9, 13, 8, 7, 6,
+        };
+        return table[((x & (0 - x)) * 0x03f79d71b4cb0a89ull) >> 58];
+#endif
+    }
+
+    inline uint64_t prefixXor(uint64_t x) {
+        x ^= x << 1;
+        x ^= x << 2;
+        x ^= x << 4;
+        x ^= x << 8;
+        x ^= x << 16;
+        x ^= x << 32;
+        return x;
+    }
+
+    /// \brief finds escapes and string bodies in consecutive 64 byte blocks
+    /// escapes are found by tracking odd-length backslash runs across blocks
+    struct StringMask {
+        uint64_t prevOddBackslash = 0;
+        uint64_t prevInString = 0;
+
+        /// \brief the bytes inside strings: the opening quote and the body are set, the
+        /// closing quote is not. quotes is set to the quotes that are not escaped
+        inline uint64_t next(const BlockMasks& m, uint64_t& quotes) {
+            static const uint64_t evenBits = 0x5555555555555555ull;
+            static const uint64_t oddBits = ~evenBits;
+
+            // chars preceded by an odd-length run of backslashes are escaped
+            auto bs = m.backslash;
+            auto startEdges = bs & ~(bs << 1);
+            auto evenStartMask = evenBits ^ prevOddBackslash;
+            auto evenStarts = startEdges & evenStartMask;
+            auto oddStarts = startEdges & ~evenStartMask;
+            auto evenCarries = bs + evenStarts;
+            auto oddCarries = bs + oddStarts;
+            auto carryOut = (oddCarries < bs) ? 1ull : 0ull;
+            oddCarries |= prevOddBackslash;
+            prevOddBackslash = carryOut;
+            auto evenCarryEnds = evenCarries & ~bs;
+            auto oddCarryEnds = oddCarries & ~bs;
+            auto escaped = (evenCarryEnds & oddBits) | (oddCarryEnds & evenBits);
+
+            quotes = m.quote & ~escaped;
+            auto inString = prefixXor(quotes) ^ prevInString;
+            prevInString = static_cast<uint64_t>(static_cast<int64_t>(inString) >> 63);
+            return inString;
+        }
+    };
+
+    /// \brief offsets in the structural index are 32 bit
+    inline bool indexable(const std::string_view& buf) {
+        return (buf.size() < std::numeric_limits<uint32_t>::max());
+    }
+
+    /// \brief stage 1: offsets of every structural char, opening quote and scalar start in buf
+    /// strings are masked out with a prefix-xor over the unescaped quotes.
+    /// the index always ends with buf.size() as a sentinel.
+    void buildStructuralIndex(const std::string_view& buf, std::vector<uint32_t>& index) {
+        if(!indexable(buf)) {
+            throw posdk::JsonError("document too large for the structural index:", std::to_string(buf.size()));
+        }
+        index.clear();
+        index.reserve(buf.size() / 4 + 2);
+
+        StringMask mask;
+        uint64_t prevScalarPred = 1;
+        char tail[64];
+        for(size_t base = 0; base < buf.size(); base += 64) {
+            const char* p = buf.data() + base;
+            if((buf.size() - base) < 64) {
+                std::fill(tail, tail + 64, ' ');
+                std::copy(p, buf.data() + buf.size(), tail);
+                p = tail;
+            }
+
+            BlockMasks m;
+            classify(p, m);
+
+            uint64_t quotes = 0;
+            auto inString = mask.next(m, quotes);
+
+            auto structural = (m.op & ~inString) | (quotes & inString);
+
+            // a scalar starts at a non-space char outside strings that follows an op or space
+            auto pred = (m.op | m.space) & ~inString;
+            auto shifted = (pred << 1) | prevScalarPred;
+            prevScalarPred = pred >> 63;
+            structural |= shifted & ~m.space & ~m.op & ~inString & ~quotes;
+
+            while(structural != 0) {
+                auto pos = base + lowestBit(structural);
+                if(pos < buf.size()) {
+                    index.push_back(static_cast<uint32_t>(pos));
+                }
+                structural &= (structural - 1);
+            }
+        }
+        index.push_back(static_cast<uint32_t>(buf.size()));
+    }
+
+    /// \brief cuts the elements of the top level array in buf into chunks of about
+    /// chunkSize bytes, at the commas between top level elements. false if buf is not
+    /// an array closed by a matching bracket, the elements themselves are not checked
+    bool splitArray(const std::string_view& buf, const size_t& chunkSize, std::vector<std::string_view>& chunks) {
+        chunks.clear();
+        size_t open = 0;
+        while((open < buf.size()) && isSpace(buf[open])) {
+            ++open;
+        }
+        if((open == buf.size()) || (buf[open] != '[')) {
+            return false;
+        }
+
+        StringMask mask;
+        size_t depth = 0;
+        size_t start = open + 1;
+        char tail[64];
+        for(size_t base = 0; base < buf.size(); base += 64) {
+            const char* p = buf.data() + base;
+            if((buf.size() - base) < 64) {
+                std::fill(tail, tail + 64, ' ');
+                std::copy(p, buf.data() + buf.size(), tail);
+                p = tail;
+            }
+
+            BlockMasks m;
+            classify(p, m);
+            uint64_t quotes = 0;
+            auto ops = m.op & ~mask.next(m, quotes);
+            while(ops != 0) {
+                auto pos = base + lowestBit(ops);
+                ops &= (ops - 1);
+                switch(buf[pos]) {
+                    case '[':
+                    case '{':
+                        ++depth;
+                        break;
+                    case ']':
+                    case '}':
+                        if(--depth == 0) {
+                            if(buf[pos] != ']') {
+                                return false;
+                            }
+                            auto last = buf.substr(start, pos - start);
+                            if(!chunks.empty() || !std::all_of(last.begin(), last.end(), isSpace)) {
+                                chunks.push_back(last);
+                            }
+                            return true;
+                        }
+                        break;
+                    case ',':
+                        if((depth == 1) && ((pos - start) >= chunkSize)) {
+                            chunks.push_back(buf.substr(start, pos - start));
+                            start = pos + 1;
+                        }
+                        break;
+                }
+            }
+        }
+        return false;
+    }
+
+    /// \brief stage 2: reports the document to handler by walking the structural index token to token
+    /// open containers are kept on an explicit stack like in ValueParser, so nesting depth is
+    /// only bounded by memory. it accepts and rejects the same input as the state machine
+    template <typename HandlerT>
+    struct IndexedParser {
+        Tokeniser& in_;
+        const std::vector<uint32_t>& index_;
+        HandlerT& handler_;
+        size_t i_;
+        StringRun str_;
+        StringRun key_;
+        std::vector<char> stack_;
+
+        inline IndexedParser(Tokeniser& in, const std::vector<uint32_t>& index, HandlerT& handler) : in_(in), index_(index), handler_(handler), i_(0) {}
+
+        /// \brief move the tokeniser to the current token and return its first char
+        inline char token() {
+            in_.skipTo(in_.begin_ + index_[i_]);
+            if(in_.eof()) {
+                ASSERT(false);
+                throw posdk::JsonError("{0}: unexpected EOF in json", in_.pos());
+            }
+            return in_.peek();
+        }
+
+        inline void expect(const char& ch) {
+            if(token() != ch) {
+                ASSERT(false);
+                throw posdk::JsonError("{0}: invalid char in json", in_.pos());
+            }
+            ++i_;
+        }
+
+        /// \brief step to the next token, which must follow the end of a scalar or string
+        /// after whitespace only. the index does not record where such a token ends, so
+        /// without this [truex] would read as [true]. at the top level the rest is left
+        /// unread, as the state machine does
+        inline void endToken() {
+            ++i_;
+            if(stack_.empty()) {
+                return;
+            }
+            auto next = in_.begin_ + index_[i_];
+            while((in_.cur_ < next) && isSpace(in_.peek())) {
+                in_.next();
+            }
+            if(in_.cur_ != next) {
+                ASSERT(false);
+                throw posdk::JsonError("{0}: invalid char in json", in_.pos());
+            }
+        }
+
+        /// \brief string whose opening quote is the current token, see endToken()
+        inline std::string_view quoted(StringRun& run) {
+            return readQuoted(in_, run);
+        }
+
+        /// \brief the handler gets scalars before the end check, as from the state machine
+        inline void literal(const char* word, const size_t& len) {
+            for(size_t i = 0; i < len; ++i) {
+                if(in_.eof()) {
+                    ASSERT(false);
+                    throw posdk::JsonError("{0}: unexpected EOF in json", in_.pos());
+                }
+                if(in_.peek() != word[i]) {
+                    ASSERT(false);
+                    throw posdk::JsonError("{0}: invalid char in json", in_.pos());
+                }
+                in_.next();
+            }
+        }
+
+        inline void number() {
+            parseNumber(in_, handler_);
+            endToken();
+        }
+
+        /// \brief "key": inside an object
+        inline void key() {
+            if(token() != '"') {
+                ASSERT(false);
+                throw posdk::JsonError("{0}: invalid char in json", in_.pos());
+            }
+            auto k = quoted(key_);
+            handler_.key(k, key_.borrowable());
+            endToken();
+            expect(':');
+        }
+
+        void value() {
+            for(;;) {
+                switch(token()) {
+                    case '{':
+                        ++i_;
+                        handler_.beginObject();
+                        if(token() == '}') {
+                            ++i_;
+                            handler_.endObject();
+                            break;
+                        }
+                        stack_.push_back('{');
+                        key();
+                        continue;
+
+                    case '[':
+                        ++i_;
+                        handler_.beginArray();
+                        if(token() == ']') {
+                            ++i_;
+                            handler_.endArray();
+                            break;
+                        }
+                        stack_.push_back('[');
+                        continue;
+
+                    case '"': {
+                        auto v = quoted(str_);
+                        handler_.value(v, str_.borrowable());
+                        endToken();
+                        break;
+                    }
+
+                    case 't':
+                        literal("true", 4);
+                        handler_.value(true);
+                        endToken();
+                        break;
+
+                    case 'f':
+                        literal("false", 5);
+                        handler_.value(false);
+                        endToken();
+                        break;
+
+                    case 'n':
+                        literal("null", 4);
+                        handler_.null();
+                        endToken();
+                        break;
+
+                    case '-':
+                    case '+':
+                    case '0':
+                    case '1':
+                    case '2':
+                    case '3':
+                    case '4':
+                    case '5':
+                    case '6':
+                    case '7':
+                    case '8':
+                    case '9':
+                        number();
+                        break;
+
+                    default:
+                        ASSERT(false);
+                        throw posdk::JsonError("{0}: invalid char in json", in_.pos());
+                }
+
+                // a value is complete: close the containers it ends, up to the next element
+                for(;;) {
+                    if(stack_.empty()) {
+                        return;
+                    }
+                    auto object = (stack_.back() == '{');
+                    if(token() == ',') {
+                        ++i_;
+                        if(!object) {
+                            break;
+                        }
+                        // like the state machine, accept a trailing comma in an object
+                        if(token() != '}') {
+                            key();
+                            break;
+                        }
+                    }
+                    expect(object ? '}' : ']');
+                    stack_.pop_back();
+                    if(object) {
+                        handler_.endObject();
+                    }else{
+                        handler_.endArray();
+                    }
+                }
+            }
+        }
+    };
+
+    /// \brief parser events to a Tree
+    /// containers are added to their parent when they begin, so the stack can point
+    /// into the parent's children: nothing is added to a parent while a child is open
+    struct TreeBuilder {
+        posdk::Json::Tree& root_;
+        bool borrowStrings_;
+        std::vector<posdk::Json::Tree*> stack_;
+        std::string_view key_;
+        bool borrowKey_;
+
+        inline TreeBuilder(posdk::Json::Tree& root, const posdk::Json::ParseOptions& opts) : root_(root), borrowStrings_(opts.borrowStrings), borrowKey_(false) {}
+
+        inline std::pmr::memory_resource* resource() const {
+            return stack_.empty() ? root_.resource() : stack_.back()->resource();
+        }
+
+        inline posdk::Json::Tree& attach(posdk::Json::Tree&& val) {
+            if(stack_.empty()) {
+                root_ = std::move(val);
+                return root_;
+            }
+            auto& parent = *stack_.back();
+            if(!parent.isObject()) {
+                return parent.add(std::move(val));
+            }
+            if(borrowKey_) {
+                return parent.addBorrowed(key_, std::move(val));
+            }
+            return parent.add(key_, std::move(val));
+        }
+
+        inline void beginObject() {
+            stack_.push_back(&attach(posdk::Json::Tree(posdk::Json::DataType::Object, resource())));
+        }
+
+        inline void endObject() {
+            stack_.pop_back();
+        }
+
+        inline void beginArray() {
+            stack_.push_back(&attach(posdk::Json::Tree(posdk::Json::DataType::Array, resource())));
+        }
+
+        inline void endArray() {
+            stack_.pop_back();
+        }
+
+        inline void key(const std::string_view& key, const bool& borrowable) {
+            key_ = key;
+            borrowKey_ = borrowStrings_ && borrowable;
+        }
+
+        inline void null() {
+            attach(posdk::Json::Tree(posdk::Json::DataType::Value, resource()));
+        }
+
+        template <typename ValT>
+        inline void value(const ValT& val) {
+            attach(posdk::Json::Tree(val));
+        }
+
+        inline void value(const std::string_view& val, const bool& borrowable) {
+            if(borrowStrings_ && borrowable) {
+                attach(posdk::Json::Tree::borrow(val, resource()));
+            }else{
+                attach(posdk::Json::Tree(val, resource()));
+            }
+        }
+    };
+
+    /// \brief parser events to a user Json::Handler
+    struct HandlerAdapter {
+        posdk::Json::Handler& handler_;
+
+        inline HandlerAdapter(posdk::Json::Handler& handler) : handler_(handler) {}
+        inline HandlerAdapter(posdk::Json::Handler& handler, const posdk::Json::ParseOptions&) : handler_(handler) {}
+
+        inline void beginObject() {
+            handler_.beginObject();
+        }
+
+        inline void endObject() {
+            handler_.endObject();
+        }
+
+        inline void beginArray() {
+            handler_.beginArray();
+        }
+
+        inline void endArray() {
+            handler_.endArray();
+        }
+
+        inline void key(const std::string_view& key, const bool&) {
+            handler_.key(key);
+        }
+
+        inline void null() {
+            handler_.null();
+        }
+
+        template <typename ValT>
+        inline void value(const ValT& val) {
+            handler_.value(val);
+        }
+
+        inline void value(const std::string_view& val, const bool&) {
+            handler_.value(val);
+        }
+    };
+
+    /// \brief the double a CBOR half precision float stands for, see RFC 8949 appendix D
+    inline double halfToDouble(const uint16_t& half) {
+        auto exp = (half >> 10) & 0x1f;
+        auto mant = half & 0x3ff;
+        double val = 0;
+        if(exp == 0) {
+            val = std::ldexp(mant, -24);
+        }else if(exp != 31) {
+            val = std::ldexp(mant + 1024, exp - 25);
+        }else{
+            val = (mant == 0) ? std::numeric_limits<double>::infinity() : std::numeric_limits<double>::quiet_NaN();
+        }
+        return (half & 0x8000) ? -val : val;
+    }
+
+    /// \brief reads CBOR (RFC 8949) one data item at a time, reporting each to a handler
+    /// and returning the matching Reader token. definite and indefinite lengths are
+    /// read, tags are skipped, byte strings are read as strings and map keys must be strings
+    struct CborCursor {
+        struct Frame {
+            bool map;
+            bool indefinite;
+            /// \brief items left in a definite container, two per map entry
+            uint64_t remaining;
+            /// \brief items started so far, the keys are the even ones in a map
+            uint64_t count;
+        };
+
+        Tokeniser& in_;
+        std::vector<Frame> stack_;
+        bool done_ = false;
+        /// \brief indefinite length strings, joined from their chunks
+        std::string key_;
+        std::string str_;
+
+        inline CborCursor(Tokeniser& in) : in_(in) {}
+
+        /// \brief file(byte offset) of the current position, for error messages
+        inline std::string pos() const {
+            std::ostringstream os;
+            os << in_.name_ << "(byte " << (in_.cur_ - in_.begin_) << ")";
+            return os.str();
+        }
+
+        inline size_t left() const {
+            return static_cast<size_t>(in_.end_ - in_.cur_);
+        }
+
+        inline uint8_t byte() {
+            if(in_.eof()) {
+                ASSERT(false);
+                throw posdk::JsonError("{0}: unexpected EOF in cbor", pos());
+            }
+            auto b = static_cast<uint8_t>(in_.peek());
+            in_.next();
+            return b;
+        }
+
+        /// \brief the argument following a head with additional info info
+        inline uint64_t argument(const uint8_t& info, bool& indefinite) {
+            indefinite = (info == 31);
+            if((info < 24) || indefinite) {
+                return info;
+            }
+            if(info > 27) {
+                ASSERT(false);
+                throw posdk::JsonError("{0}: invalid cbor", pos());
+            }
+            size_t bytes = static_cast<size_t>(1) << (info - 24);
+            if(left() < bytes) {
+                ASSERT(false);
+                throw posdk::JsonError("{0}: unexpected EOF in cbor", pos());
+            }
+            uint64_t arg = 0;
+            for(size_t i = 0; i < bytes; ++i) {
+                arg = (arg << 8) | static_cast<uint8_t>(in_.cur_[i]);
+            }
+            in_.skipTo(in_.cur_ + bytes);
+            return arg;
+        }
+
+        inline void skipTags() {
+            while(!in_.eof() && ((static_cast<uint8_t>(in_.peek()) >> 5) == 6)) {
+                bool indefinite = false;
+                argument(byte() & 31, indefinite);
+                if(indefinite) {
+                    ASSERT(false);
+                    throw posdk::JsonError("{0}: invalid cbor", pos());
+                }
+            }
+        }
+
+        /// \brief a text or byte string of len bytes, joined into buf when it has indefinite length
+        inline std::string_view string(const uint8_t& major, const uint64_t& len, const bool& indefinite, std::string& buf, bool& borrowable) {
+            borrowable = !indefinite;
+            if(!indefinite) {
+                if(left() < len) {
+                    ASSERT(false);
+                    throw posdk::JsonError("{0}: unexpected EOF in cbor", pos());
+                }
+                std::string_view str(in_.cur_, static_cast<size_t>(len));
+                in_.skipTo(in_.cur_ + len);
+                return str;
+            }
+            buf.clear();
+            for(;;) {
+                auto head = byte();
+                if(head == 0xff) {
+                    return buf;
+                }
+                bool chunkIndefinite = false;
+                auto chunk = argument(head & 31, chunkIndefinite);
+                if(((head >> 5) != major) || chunkIndefinite) {
+                    ASSERT(false);
+                    throw posdk::JsonError("{0}: invalid cbor", pos());
+                }
+                if(left() < chunk) {
+                    ASSERT(false);
+                    throw posdk::JsonError("{0}: unexpected EOF in cbor", pos());
+                }
+                buf.append(in_.cur_, static_cast<size_t>(chunk));
+                in_.skipTo(in_.cur_ + chunk);
+            }
+        }
+
+        /// \brief the token next() will return, without consuming it
+        inline posdk::Json::Token peek() {
+            if(done_) {
+                return posdk::Json::Token::End;
+            }
+            skipTags();
+            if(!stack_.empty()) {
+                auto& top = stack_.back();
+                if(top.indefinite ? (!in_.eof() && (static_cast<uint8_t>(in_.peek()) == 0xff)) : (top.remaining == 0)) {
+                    return top.map ? posdk::Json::Token::EndObject : posdk::Json::Token::EndArray;
+                }
+                if(top.map && ((top.count % 2) == 0)) {
+                    return posdk::Json::Token::Key;
+                }
+            }
+            if(in_.eof()) {
+                ASSERT(false);
+                throw posdk::JsonError("{0}: unexpected EOF in cbor", pos());
+            }
+            switch(static_cast<uint8_t>(in_.peek()) >> 5) {
+                case 4:
+                    return posdk::Json::Token::BeginArray;
+                case 5:
+                    return posdk::Json::Token::BeginObject;
+            }
+            return posdk::Json::Token::Value;
+        }
+
+        template <typename HandlerT>
+        inline posdk::Json::Token next(HandlerT& handler) {
+            auto tok = peek();
+            if(tok == posdk::Json::Token::End) {
+                return tok;
+            }
+            if((tok == posdk::Json::Token::EndObject) || (tok == posdk::Json::Token::EndArray)) {
+                auto top = stack_.back();
+                if(top.indefinite) {
+                    in_.next();
+                }
+                if(top.map && ((top.count % 2) != 0)) {
+                    ASSERT(false);
+                    throw posdk::JsonError("{0}: cbor map key without a value", pos());
+                }
+                stack_.pop_back();
+                done_ = stack_.empty();
+                if(top.map) {
+                    handler.endObject();
+                }else{
+                    handler.endArray();
+                }
+                return tok;
+            }
+
+            if(!stack_.empty()) {
+                auto& top = stack_.back();
+                ++top.count;
+                if(!top.indefinite) {
+                    --top.remaining;
+                }
+            }
+            auto head = byte();
+            uint8_t major = head >> 5;
+            bool indefinite = false;
+            auto arg = argument(head & 31, indefinite);
+            if(indefinite && ((major < 2) || (major > 5))) {
+                ASSERT(false);
+                throw posdk::JsonError("{0}: invalid cbor", pos());
+            }
+            bool borrowable = false;
+            if(tok == posdk::Json::Token::Key) {
+                if((major != 2) && (major != 3)) {
+                    ASSERT(false);
+                    throw posdk::JsonError("{0}: cbor map key is not a string", pos());
+                }
+                handler.key(string(major, arg, indefinite, key_, borrowable), borrowable);
+                return tok;
+            }
+
+            switch(major) {
+                case 0:
+                    if(arg > static_cast<uint64_t>(std::numeric_limits<posdk::Json::integer_t>::max())) {
+                        handler.value(static_cast<posdk::Json::uinteger_t>(arg));
+                    }else{
+                        handler.value(static_cast<posdk::Json::integer_t>(arg));
+                    }
+                    break;
+
+                case 1:
+                    if(arg > static_cast<uint64_t>(std::numeric_limits<posdk::Json::integer_t>::max())) {
+                        ASSERT(false);
+                        throw posdk::JsonError("{0}: integer out of range in cbor", pos());
+                    }
+                    handler.value(static_cast<posdk::Json::integer_t>(-1 - static_cast<posdk::Json::integer_t>(arg)));
+                    break;
+
+                case 2:
+                case 3:
+                    handler.value(string(major, arg, indefinite, str_, borrowable), borrowable);
+                    break;
+
+                case 4:
+                case 5:
+                    // every item takes at least one byte, which also bounds the count
+                    if(!indefinite && (arg > left())) {
+                        ASSERT(false);
+                        throw posdk::JsonError("{0}: unexpected EOF in cbor", pos());
+                    }
+                    stack_.push_back(Frame{major == 5, indefinite, (major == 5) ? arg * 2 : arg, 0});
+                    if(major == 5) {
+                        handler.beginObject();
+                    }else{
+                        handler.beginArray();
+                    }
+                    return tok;
+
+                default:
+                    switch(head & 31) {
+                        case 20:
+                            handler.value(false);
+                            break;
+                        case 21:
+                            handler.value(true);
+                            break;
+                        case 22:
+                        case 23:
+                            handler.null();
+                            break;
+                        case 25:
+                            handler.value(halfToDouble(static_cast<uint16_t>(arg)));
+                            break;
+                        case 26: {
+                            auto bits = static_cast<uint32_t>(arg);
+                            float val = 0;
+                            std::memcpy(&val, &bits, sizeof(val));
+                            handler.value(static_cast<posdk::Json::float_t>(val));
+                            break;
+                        }
+                        case 27: {
+                            posdk::Json::float_t val = 0;
+                            std::memcpy(&val, &arg, sizeof(val));
+                            handler.value(val);
+                            break;
+                        }
+                        default:
+                            ASSERT(false);
+                            throw posdk::JsonError("{0}: invalid cbor", pos());
+                    }
+                    break;
+            }
+            done_ = stack_.empty();
+            return tok;
+        }
+    };
+
+    /// \brief read one CBOR data item and report it to handler, only it may be in the input
+    template <typename HandlerT>
+    inline void parseCbor(Tokeniser& in, HandlerT& handler) {
+        CborCursor cursor(in);
+        while(cursor.next(handler) != posdk::Json::Token::End) {
+        }
+        if(!in.eof()) {
+            ASSERT(false);
+            throw posdk::JsonError("{0}: unexpected data after cbor", cursor.pos());
+        }
+    }
+
+    /// \brief keeps the key or scalar value of one Reader token
+    struct TokenCapture {
+        std::string_view& key_;
+        posdk::Json::Tree& value_;
+
+        inline void beginObject() {}
+        inline void endObject() {}
+        inline void beginArray() {}
+        inline void endArray() {}
+
+        inline void key(const std::string_view& key, const bool&) {
+            key_ = key;
+        }
+
+        inline void null() {
+            value_ = posdk::Json::Tree();
+        }
+
+        template <typename ValT>
+        inline void value(const ValT& val) {
+            value_ = posdk::Json::Tree(val);
+        }
+
+        inline void value(const std::string_view& val, const bool&) {
+            value_ = posdk::Json::Tree::borrow(val);
+        }
+    };
+
+    template <typename HandlerT>
+    inline void parseBuffer(const std::string_view& buf, const std::string& filename, HandlerT& handler, const posdk::Json::ParseOptions& opts) {
+        Tokeniser tok(buf.data(), buf.data() + buf.size(), filename, opts);
+        if(opts.encoding == posdk::Json::Encoding::Cbor) {
+            return parseCbor(tok, handler);
+        }
+        // documents of 4GB and more fall back to the state machine
+        if(opts.structuralIndex && indexable(buf)) {
+            std::vector<uint32_t> index;
+            buildStructuralIndex(buf, index);
+            IndexedParser<HandlerT> parser(tok, index, handler);
+            return parser.value();
+        }
+        return parseValue(tok, handler);
+    }
+
+    inline void skipSpace(Tokeniser& in) {
+        while(!in.eof() && isSpace(in.peek())) {
+            in.next();
+        }
+    }
+
+    /// \brief step over the container whose opening bracket is at the tokeniser position
+    /// brackets outside strings are counted 64 bytes at a time with the structural index
+    /// masks, the contents are only checked when the container is expanded
+    inline void skipContainer(Tokeniser& in) {
+        StringMask mask;
+        size_t depth = 0;
+        size_t size = static_cast<size_t>(in.end_ - in.cur_);
+        char tail[64];
+        for(size_t base = 0; base < size; base += 64) {
+            const char* p = in.cur_ + base;
+            if((size - base) < 64) {
+                std::fill(tail, tail + 64, ' ');
+                std::copy(p, in.end_, tail);
+                p = tail;
+            }
+
+            BlockMasks m;
+            classify(p, m);
+            uint64_t quotes = 0;
+            auto ops = m.op & ~mask.next(m, quotes);
+            while(ops != 0) {
+                auto pos = lowestBit(ops);
+                ops &= (ops - 1);
+                switch(p[pos]) {
+                    case '[':
+                    case '{':
+                        ++depth;
+                        break;
+                    case ']':
+                    case '}':
+                        if(--depth == 0) {
+                            in.skipTo(in.cur_ + base + pos + 1);
+                            return;
+                        }
+                        break;
+                }
+            }
+        }
+        in.skipTo(in.end_);
+        ASSERT(false);
+        throw posdk::JsonError("{0}: unexpected EOF in json", in.pos());
+    }
+
+    /// \brief container at the tokeniser position as a deferred tree, see ParseOptions::lazy
+    inline posdk::Json::Tree deferContainer(Tokeniser& in, std::pmr::memory_resource* mr) {
+        auto begin = in.cur_;
+        skipContainer(in);
+        return posdk::Json::Tree::deferred(std::string_view(begin, static_cast<size_t>(in.cur_ - begin)), mr, in.name_, in.begin_);
+    }
+}
+
+posdk::Json::Tree::iterator posdk::Json::Tree::find(const std::string_view& key) const {
+    auto idx = indexOf(key);
+    if(idx == children_.size()){
+        throw posdk::JsonError("json key not found:" + std::string(key));
+    }
+    return iterator(this, idx);
+}
+
+namespace {
+    /// \brief lock for expanding the node at p, one of a few picked by its address
+    inline std::mutex& expandLock(const void* p) {
+        static std::mutex locks[64];
+        return locks[(reinterpret_cast<uintptr_t>(p) / sizeof(posdk::Json::Tree)) % 64];
+    }
+}
+
+void posdk::Json::Tree::expandPending() const {
+    std::lock_guard<std::mutex> lock(expandLock(this));
+    // another thread may have expanded it while this one waited
+    switch(pending_.load(std::memory_order_relaxed)) {
+        case Pending::None:
+            return;
+        case Pending::Deferred:
+            parseDeferred();
+            break;
+        case Pending::Packed:
+            unpackChildren();
+            break;
+    }
+    // readers that see None with acquire order also see the children
+    pending_.store(Pending::None, std::memory_order_release);
+}
+
+void posdk::Json::Tree::parseDeferred() const {
+    // value keeps the text, readers that saw the container deferred may still look at it
+    auto raw = std::get<strview_t>(value);
+    // keys_ holds the name and start of the input, see deferred()
+    const std::string name(keys_.at(0).view());
+    auto input = keys_.at(1).data;
+    clearKeys();
+    ParseOptions opts;
+    opts.borrowStrings = true;
+    // the tokeniser starts at the input, so errors report the position in it
+    Tokeniser in(input, raw.data() + raw.size(), name, opts);
+    in.skipTo(raw.data());
+    auto object = (dataType_ == DataType::Object);
+    auto close = object ? '}' : ']';
+    try {
+        Tree val(DataType::Value, resource());
+        TreeBuilder builder(val, opts);
+        ValueParser<TreeBuilder> parser(builder);
+        StringRun key;
+        in.next();
+        skipSpace(in);
+        if(!in.eof() && (in.peek() == close)) {
+            in.next();
+            return;
+        }
+        for(;;) {
+            std::string_view k;
+            if(object) {
+                if(in.eof() || (in.peek() != '"')) {
+                    ASSERT(false);
+                    throw posdk::JsonError("{0}: invalid char in json", in.pos());
+                }
+                k = readQuoted(in, key);
+                skipSpace(in);
+                if(in.eof() || (in.peek() != ':')) {
+                    ASSERT(false);
+                    throw posdk::JsonError("{0}: invalid char in json", in.pos());
+                }
+                in.next();
+                skipSpace(in);
+            }
+            if(in.eof()) {
+                ASSERT(false);
+                throw posdk::JsonError("{0}: unexpected EOF in json", in.pos());
+            }
+            if((in.peek() == '{') || (in.peek() == '[')) {
+                val = deferContainer(in, resource());
+            }else{
+                parser.s_ = ParserState::EnterValue;
+                parser.run(in);
+            }
+            // add() would expand this container again
+            if(!object) {
+                children_.push_back(std::move(val));
+            }else if(k.size() == 0) {
+                throw posdk::JsonError("key length is zero");
+            }else if(key.borrowable()) {
+                appendKey(Key{hashKey(k), static_cast<uint32_t>(k.size()), 1, k.data()}, std::move(val));
+            }else{
+                appendKey(makeKey(k, resource()), std::move(val));
+            }
+            skipSpace(in);
+            if(in.eof()) {
+                ASSERT(false);
+                throw posdk::JsonError("{0}: unexpected EOF in json", in.pos());
+            }
+            auto ch = in.peek();
+            if(ch == close) {
+                in.next();
+                return;
+            }
+            if(ch != ',') {
+                ASSERT(false);
+                throw posdk::JsonError("{0}: invalid char in json", in.pos());
+            }
+            in.next();
+            skipSpace(in);
+            // like the full parser, accept a trailing comma in an object
+            if(object && !in.eof() && (in.peek() == close)) {
+                in.next();
+                return;
+            }
+        }
+    }catch(...) {
+        // stay deferred, so the next access reports the error again
+        clearKeys();
+        freeIndex();
+        children_.clear();
+        setSource(name, input);
+        throw;
+    }
+}
+
+void posdk::Json::Tree::destroyChildren() {
+    static thread_local size_t depth = 0;
+    if(depth < 1024) {
+        ++depth;
+        children_.clear();
+        --depth;
+        return;
+    }
+    // too deep to recurse: move every grandchild out before its parent is destroyed
+    std::vector<Tree> pending;
+    for(auto& c : children_) {
+        pending.push_back(std::move(c));
+    }
+    children_.clear();
+    while(!pending.empty()) {
+        Tree t(std::move(pending.back()));
+        pending.pop_back();
+        for(auto& c : t.children_) {
+            pending.push_back(std::move(c));
+        }
+        t.children_.clear();
+    }
+}
+
+void posdk::Json::Tree::unpackChildren() const {
+    // value keeps the buffer, readers that saw the array packed may still read it
+    auto data = packedData();
+    auto type = packedType();
+    auto count = data.size() / packedWidth(type);
+    try {
+        children_.reserve(count);
+        visitPacked(type, [&](auto zero) {
+            typedef decltype(zero) ValT;
+            for(size_t i = 0; i < count; ++i) {
+                ValT val;
+                std::memcpy(&val, data.data() + (i * sizeof(ValT)), sizeof(ValT));
+                children_.emplace_back(val);
+            }
+        });
+    }catch(...) {
+        children_.clear();
+        throw;
+    }
+}
+
+namespace {
+    /// \brief spaces per level for the save functions, which keep the original layout of
+    /// 2 spaces per level for any non-zero indent. a Writer takes the spaces per level
+    inline size_t saveIndent(const size_t& indent) {
+        return (indent == 0) ? 0 : 2;
+    }
+}
+
+void posdk::Json::Tree::print(std::ostream& os, const size_t& lvl, const size_t& indent) const {
+    OstreamSink sink(os);
+    Writer writer(sink, saveIndent(indent));
+    writer.nest(lvl);
+    write(writer);
+    writer.flush();
+}
+
+void posdk::Json::Tree::write(Writer& writer) const {
+    if(isPacked()) {
+        auto data = packedData();
+        writer.packed(packedType(), data.data(), data.size() / packedWidth(packedType()));
+        return;
+    }
+    expand();
+    switch(dataType_){
+    case DataType::Object:
+        writer.beginObject();
+        for(size_t i = 0; i < children_.size(); ++i){
+            writer.key(keyAt(i));
+            children_[i].write(writer);
+        }
+        writer.endObject();
+        break;
+    case DataType::Array:
+        writer.beginArray();
+        for(auto& c : children_){
+            c.write(writer);
+        }
+        writer.endArray();
+        break;
+    case DataType::Value:
+        std::visit([this, &writer](const auto& val){
+            typedef typename std::decay<decltype(val)>::type ValT;
+            if constexpr (std::is_same<ValT, null_t>::value) {
+                writer.null();
+            } else if constexpr (std::is_same<ValT, float_t>::value) {
+                if(single_) {
+                    writer.value(static_cast<float>(val));
+                }else{
+                    writer.value(val);
+                }
+            } else {
+                writer.value(val);
+            }
+        }, value);
+        break;
+    }
+}
+
+void posdk::Json::Writer::appendString(const std::string_view& str) {
+    static const char hex[] = "0123456789abcdef";
+    buf_.reserve(buf_.size() + str.size() + 2);
+    buf_ += '"';
+    auto p = str.data();
+    auto end = p + str.size();
+    for(;;) {
+        // copy the clean run up to the next quote, backslash or control char in bulk
+        auto e = scanString(p, end);
+        buf_.append(p, e);
+        if(e == end) {
+            break;
+        }
+        switch(*e) {
+        case '"':
+            buf_ += "\\\"";
+            break;
+        case '\\':
+            buf_ += "\\\\";
+            break;
+        case '\b':
+            buf_ += "\\b";
+            break;
+        case '\f':
+            buf_ += "\\f";
+            break;
+        case '\n':
+            buf_ += "\\n";
+            break;
+        case '\r':
+            buf_ += "\\r";
+            break;
+        case '\t':
+            buf_ += "\\t";
+            break;
+        default: {
+            char u[] = {'\\', 'u', '0', '0', hex[(*e >> 4) & 0xf], hex[*e & 0xf]};
+            buf_.append(u, sizeof(u));
+            break;
+        }
+        }
+        p = e + 1;
+    }
+    buf_ += '"';
+}
+
+void posdk::Json::Writer::appendCborHead(const uint8_t& major, const uint64_t& arg) {
+    auto head = static_cast<char>(major << 5);
+    if(arg < 24) {
+        buf_ += static_cast<char>(head | static_cast<char>(arg));
+        return;
+    }
+    // additional info 24..27 is followed by 1, 2, 4 or 8 big-endian bytes
+    size_t bytes = (arg <= 0xff) ? 1 : (arg <= 0xffff) ? 2 : (arg <= 0xffffffffull) ? 4 : 8;
+    char tmp[9];
+    tmp[0] = static_cast<char>(head | static_cast<char>((bytes == 1) ? 24 : (bytes == 2) ? 25 : (bytes == 4) ? 26 : 27));
+    for(size_t i = 0; i < bytes; ++i) {
+        tmp[bytes - i] = static_cast<char>((arg >> (i * 8)) & 0xff);
+    }
+    buf_.append(tmp, bytes + 1);
+}
+
+void posdk::Json::Writer::appendCbor(const integer_t& val) {
+    if(val < 0) {
+        // major type 1 holds -1 - val
+        appendCborHead(1, static_cast<uint64_t>(-(val + 1)));
+    }else{
+        appendCborHead(0, static_cast<uint64_t>(val));
+    }
+}
+
+void posdk::Json::Writer::appendCbor(const float_t& val) {
+    char tmp[9];
+    // single precision when that is exact, as the shortest form
+    auto f = static_cast<float>(val);
+    if((static_cast<float_t>(f) == val) || std::isnan(val)) {
+        uint32_t bits = 0;
+        std::memcpy(&bits, &f, sizeof(bits));
+        tmp[0] = '\xfa';
+        for(size_t i = 0; i < 4; ++i) {
+            tmp[4 - i] = static_cast<char>((bits >> (i * 8)) & 0xff);
+        }
+        buf_.append(tmp, 5);
+        return;
+    }
+    uint64_t bits = 0;
+    std::memcpy(&bits, &val, sizeof(bits));
+    tmp[0] = '\xfb';
+    for(size_t i = 0; i < 8; ++i) {
+        tmp[8 - i] = static_cast<char>((bits >> (i * 8)) & 0xff);
+    }
+    buf_.append(tmp, 9);
+}
+
+void posdk::Json::Writer::appendNumber(const integer_t& val) {
+    char tmp[24];
+    auto end = tmp + sizeof(tmp);
+    auto begin = formatUnsigned((val < 0) ? (0 - static_cast<uint64_t>(val)) : static_cast<uint64_t>(val), end);
+    if(val < 0) {
+        *--begin = '-';
+    }
+    buf_.append(begin, end);
+}
+
+void posdk::Json::Writer::appendNumber(const uinteger_t& val) {
+    char tmp[24];
+    auto end = tmp + sizeof(tmp);
+    buf_.append(formatUnsigned(val, end), end);
+}
+
+namespace {
+    /// \brief shortest representation that reads back as the same FloatT, so a float
+    /// 12.3f is written as 12.3 and a double as all the digits it needs
+    template <typename FloatT>
+    inline void appendFloat(std::string& buf, const FloatT& val) {
+        // Json has no inf or nan
+        if(!std::isfinite(val)) {
+            buf += "null";
+            return;
+        }
+        char tmp[32];
+#ifdef __cpp_lib_to_chars
+        auto end = std::to_chars(tmp, tmp + sizeof(tmp), val).ptr;
+#else
+        auto end = tmp + std::snprintf(tmp, sizeof(tmp), std::is_same<FloatT, float>::value ? "%.9g" : "%.17g", static_cast<double>(val));
+#endif
+        buf.append(tmp, end);
+        // keep it a float when read back
+        if(std::find_if(tmp, end, [](const char& ch){ return (ch == '.') || (ch == 'e'); }) == end) {
+            buf += ".0";
+        }
+    }
+}
+
+void posdk::Json::Writer::appendNumber(const float_t& val) {
+    appendFloat(buf_, val);
+}
+
+void posdk::Json::Writer::appendNumber(const float& val) {
+    appendFloat(buf_, val);
+}
+
+void posdk::Json::Writer::packed(const Packed& type, const char* data, const size_t& count) {
+    if(packArrays_) {
+        beginObject();
+        key("__packed__");
+        value(packedName(type));
+        key("__data__");
+        value(encodeBase64(data, count * packedWidth(type)));
+        endObject();
+        return;
+    }
+    beginArray();
+    visitPacked(type, [&](auto zero) {
+        typedef decltype(zero) ValT;
+        for(size_t i = 0; i < count; ++i) {
+            ValT val;
+            std::memcpy(&val, data + (i * sizeof(ValT)), sizeof(ValT));
+            value(val);
+        }
+    });
+    endArray();
+}
+
+void posdk::Json::load(const std::string_view& buf, const std::string& filename, posdk::Json::Tree& tree, const ParseOptions& opts) {
+    if(opts.lazy && (opts.encoding == Encoding::Json)) {
+        Tokeniser in(buf.data(), buf.data() + buf.size(), filename, opts);
+        skipSpace(in);
+        if(!in.eof() && ((in.peek() == '{') || (in.peek() == '['))) {
+            tree = deferContainer(in, tree.resource());
+            tree.expand();
+            return;
+        }
+    }
+    TreeBuilder builder(tree, opts);
+    parseBuffer(buf, filename, builder, opts);
+}
+
+void posdk::Json::parse(const std::string_view& buf, const std::string& filename, Handler& handler, const ParseOptions& opts) {
+    HandlerAdapter adapter(handler);
+    parseBuffer(buf, filename, adapter, opts);
+}
+
+namespace {
+    /// \brief append the next value in the stream to buf, and stop right after it so that
+    /// the stream can hold more data. only brackets, quotes and escapes are tracked here,
+    /// the text is checked when buf is parsed
+    void readValue(std::istream& in, std::string& buf) {
+        typedef std::istream::traits_type traits;
+        auto sb = in.rdbuf();
+        size_t depth = 0;
+        bool started = false;
+        bool quoted = false;
+        bool escaped = false;
+        for(;;) {
+            auto c = sb->sgetc();
+            if(traits::eq_int_type(c, traits::eof())) {
+                in.setstate(std::ios::eofbit);
+                return;
+            }
+            auto ch = traits::to_char_type(c);
+            if(quoted) {
+                sb->sbumpc();
+                buf += ch;
+                if(escaped) {
+                    escaped = false;
+                }else if(ch == '\\') {
+                    escaped = true;
+                }else if(ch == '"') {
+                    quoted = false;
+                    if(depth == 0) {
+                        return;
+                    }
+                }
+                continue;
+            }
+            // a top level number or literal ends before the next delimiter
+            auto top = (depth == 0);
+            switch(ch) {
+                case 0:
+                case ' ':
+                case '\t':
+                case '\r':
+                case '\n':
+                    if(top && started) {
+                        return;
+                    }
+                    sb->sbumpc();
+                    buf += ch;
+                    continue;
+                case '"':
+                    quoted = true;
+                    break;
+                case '{':
+                case '[':
+                    ++depth;
+                    break;
+                case '}':
+                case ']':
+                case ',':
+                case ':':
+                    if(top) {
+                        if(!started) {
+                            // stray delimiter, left for the parser to report
+                            sb->sbumpc();
+                            buf += ch;
+                        }
+                        return;
+                    }
+                    if((ch == '}') || (ch == ']')) {
+                        --depth;
+                    }
+                    break;
+            }
+            if(top && started && ((ch == '"') || (ch == '{') || (ch == '['))) {
+                return;
+            }
+            sb->sbumpc();
+            buf += ch;
+            started = true;
+            if(!top && (depth == 0)) {
+                return;
+            }
+        }
+    }
+}
+
+void posdk::Json::load(std::istream& in, const std::string& filename, posdk::Json::Tree& tree) {
+    std::string buf;
+    readValue(in, buf);
+    load(std::string_view(buf), filename, tree);
+}
+
+posdk::Json::Tree posdk::Json::loadFromString(const std::string& str, const ParseOptions& opts) {
+    posdk::Json::Tree tree(posdk::Json::DataType::Value);
+    if(str.size() == 0) {
+        return tree;
+    }
+
+    load(std::string_view(str), "<str>", tree, opts);
+    return tree;
+}
+
+posdk::Json::Tree& posdk::Json::loadFromString(const std::string& str, Arena& arena, const ParseOptions& opts) {
+    auto mr = arena.resource();
+    auto tree = new (mr->allocate(sizeof(Tree), alignof(Tree))) posdk::Json::Tree(posdk::Json::DataType::Value, mr);
+    if(str.size() == 0) {
+        return *tree;
+    }
+
+    load(std::string_view(str), "<str>", *tree, opts);
+    return *tree;
+}
+
+void posdk::Json::save(std::ostream& os, const Tree& tree, const size_t& indent) {
+    OstreamSink sink(os);
+    Writer writer(sink, saveIndent(indent));
+    writer.value(tree);
+    writer.flush();
+}
+
+std::string posdk::Json::saveToString(const Tree& tree, const size_t& indent) {
+    Writer writer(saveIndent(indent));
+    writer.value(tree);
+    return writer.release();
+}
+
+std::string posdk::Json::saveToString(const Tree& tree, const Encoding& encoding) {
+    Writer writer(encoding);
+    writer.value(tree);
+    return writer.release();
+}
+
+posdk::Json::MappedFile::MappedFile(const std::string& filename) : filename_(filename), data_(nullptr), size_(0), mapped_(false) {
+#ifdef HAVE_MMAP
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if(fd < 0) {
+        throw posdk::JsonError("file not found:" + filename);
+    }
+
+    struct stat st;
+    if((::fstat(fd, &st) == 0) && S_ISREG(st.st_mode) && (st.st_size > 0)) {
+        void* p = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if(p != MAP_FAILED) {
+            ::madvise(p, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+            data_ = static_cast<const char*>(p);
+            size_ = static_cast<size_t>(st.st_size);
+            mapped_ = true;
+            ::close(fd);
+            return;
+        }
+    }
+
+    // pipes, character devices and anything mmap refuses: buffered read
+    char chunk[64 * 1024];
+    for(;;) {
+        auto n = ::read(fd, chunk, sizeof(chunk));
+        if(n < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            ::close(fd);
+            throw posdk::JsonError("error reading file:" + filename);
+        }
+        if(n == 0) {
+            break;
+        }
+        buffer_.append(chunk, static_cast<size_t>(n));
+    }
+    ::close(fd);
+#else
+    std::ifstream ifs(filename, std::ios::binary);
+    if(!ifs) {
+        throw posdk::JsonError("file not found:" + filename);
+    }
+    buffer_.assign((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+#endif
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+}
+
+posdk::Json::MappedFile::~MappedFile() {
+#ifdef HAVE_MMAP
+    if(mapped_) {
+        ::munmap(const_cast<char*>(data_), size_);
+    }
+#endif
+}
+
+posdk::Json::Tree posdk::Json::loadFromFile(const MappedFile& file, const ParseOptions& opts) {
+    posdk::Json::Tree tree(posdk::Json::DataType::Value);
+    load(file.view(), file.filename(), tree, opts);
+    return tree;
+}
+
+posdk::Json::Tree posdk::Json::loadFromFile(const std::string& filename) {
+    MappedFile file(filename);
+    return loadFromFile(file);
+}
+
+void posdk::Json::saveToFile(const Tree& tree, const std::string& filename, const size_t& indent) {
+    std::ofstream ofs(filename);
+    save(ofs, tree, indent);
+}
+
+/// \brief parser position and the container stack of a Reader
+struct posdk::Json::Reader::State {
+    std::string name_;
+    ParseOptions opts_;
+    Tokeniser in_;
+    /// \brief '{' or '[' for each open container
+    std::vector<char> stack_;
+    /// \brief nothing read yet in the innermost container
+    bool first_;
+    /// \brief a key was read, ':' and its value follow
+    bool afterKey_;
+    /// \brief the top level value has been read
+    bool done_;
+    /// \brief separators before the next token have been consumed
+    bool ready_;
+    StringRun keyRun_;
+    StringRun valueRun_;
+    std::string_view key_;
+    Tree value_;
+    TreeBuilder valueBuilder_;
+    CborCursor cbor_;
+
+    inline State(const std::string_view& buf, const std::string& name, const ParseOptions& opts)
+    : name_(name), opts_(opts), in_(buf.data(), buf.data() + buf.size(), name_, opts_)
+    , first_(true), afterKey_(false), done_(false), ready_(false), valueBuilder_(value_, opts_), cbor_(in_) {}
+
+    inline bool isCbor() const {
+        return (opts_.encoding == Encoding::Cbor);
+    }
+
+    inline void skipSpace() {
+        while(!in_.eof()) {
+            switch(in_.peek()) {
+                case 0:
+                case ' ':
+                case '\t':
+                case '\r':
+                case '\n':
+                    in_.next();
+                    continue;
+            }
+            break;
+        }
+    }
+
+    inline void consume(const char& ch) {
+        if(in_.eof() || (in_.peek() != ch)) {
+            ASSERT(false);
+            throw posdk::JsonError("{0}: invalid char in json", in_.pos());
+        }
+        in_.next();
+        skipSpace();
+    }
+
+    /// \brief consume the ':' or ',' in front of the next token
+    inline void prepare() {
+        if(ready_) {
+            return;
+        }
+        ready_ = true;
+        skipSpace();
+        if(done_ || stack_.empty() || in_.eof()) {
+            return;
+        }
+        if(afterKey_) {
+            consume(':');
+            return;
+        }
+        auto close = (stack_.back() == '{') ? '}' : ']';
+        if(!first_ && (in_.peek() != close)) {
+            consume(',');
+            if(!in_.eof() && (in_.peek() == close)) {
+                ASSERT(false);
+                throw posdk::JsonError("{0}: invalid char in json", in_.pos());
+            }
+        }
+    }
+
+    /// \brief a value starts, at the top level or in the innermost container
+    inline void beginValue() {
+        if(!stack_.empty() && (stack_.back() == '{') && !afterKey_) {
+            ASSERT(false);
+            throw posdk::JsonError("{0}: expected key in json", in_.pos());
+        }
+        afterKey_ = false;
+        first_ = false;
+    }
+
+    inline void endValue() {
+        if(stack_.empty()) {
+            done_ = true;
+        }
+    }
+
+    inline void literal(const char* word, const size_t& len) {
+        if((static_cast<size_t>(in_.end_ - in_.cur_) < len) || !std::equal(word, word + len, in_.cur_)) {
+            ASSERT(false);
+            throw posdk::JsonError("{0}: invalid char in json", in_.pos());
+        }
+        in_.skipTo(in_.cur_ + len);
+    }
+
+    inline posdk::Json::Token close(const char& open) {
+        if(stack_.empty() || (stack_.back() != open) || afterKey_) {
+            ASSERT(false);
+            throw posdk::JsonError("{0}: invalid char in json", in_.pos());
+        }
+        in_.next();
+        stack_.pop_back();
+        first_ = false;
+        endValue();
+        return (open == '{') ? posdk::Json::Token::EndObject : posdk::Json::Token::EndArray;
+    }
+
+    posdk::Json::Token next() {
+        if(isCbor()) {
+            TokenCapture capture{key_, value_};
+            return cbor_.next(capture);
+        }
+        prepare();
+        ready_ = false;
+        if(done_) {
+            return posdk::Json::Token::End;
+        }
+        if(in_.eof()) {
+            ASSERT(false);
+            throw posdk::JsonError("{0}: unexpected EOF in json", in_.pos());
+        }
+        auto ch = in_.peek();
+        switch(ch) {
+            case '}':
+                return close('{');
+            case ']':
+                return close('[');
+        }
+
+        if(!stack_.empty() && (stack_.back() == '{') && !afterKey_) {
+            if(ch != '"') {
+                ASSERT(false);
+                throw posdk::JsonError("{0}: expected key in json", in_.pos());
+            }
+            key_ = readQuoted(in_, keyRun_);
+            first_ = false;
+            afterKey_ = true;
+            return posdk::Json::Token::Key;
+        }
+
+        beginValue();
+        switch(ch) {
+            case '{':
+            case '[':
+                in_.next();
+                stack_.push_back(ch);
+                first_ = true;
+                return (ch == '{') ? posdk::Json::Token::BeginObject : posdk::Json::Token::BeginArray;
+            case '"':
+                value_ = Tree::borrow(readQuoted(in_, valueRun_));
+                break;
+            case 't':
+                literal("true", 4);
+                value_ = Tree(true);
+                break;
+            case 'f':
+                literal("false", 5);
+                value_ = Tree(false);
+                break;
+            case 'n':
+                literal("null", 4);
+                value_ = Tree();
+                break;
+            default:
+                parseNumber(in_, valueBuilder_);
+                break;
+        }
+        endValue();
+        return posdk::Json::Token::Value;
+    }
+};
+
+posdk::Json::Reader::Reader(const std::string_view& buf, const std::string& filename, const ParseOptions& opts) : state_(new State(buf, filename, opts)) {}
+
+posdk::Json::Reader::~Reader() {}
+
+posdk::Json::Token posdk::Json::Reader::peek() {
+    auto& st = *state_;
+    if(st.isCbor()) {
+        return st.cbor_.peek();
+    }
+    st.prepare();
+    if(st.done_) {
+        return Token::End;
+    }
+    if(st.in_.eof()) {
+        ASSERT(false);
+        throw posdk::JsonError("{0}: unexpected EOF in json", st.in_.pos());
+    }
+    switch(st.in_.peek()) {
+        case '{':
+            return Token::BeginObject;
+        case '}':
+            return Token::EndObject;
+        case '[':
+            return Token::BeginArray;
+        case ']':
+            return Token::EndArray;
+    }
+    if(!st.stack_.empty() && (st.stack_.back() == '{') && !st.afterKey_) {
+        return Token::Key;
+    }
+    return Token::Value;
+}
+
+posdk::Json::Token posdk::Json::Reader::next() {
+    return state_->next();
+}
+
+void posdk::Json::Reader::expect(const Token& tok) {
+    if(next() != tok) {
+        throw posdk::JsonError("{0}: unexpected token in json", pos());
+    }
+}
+
+void posdk::Json::Reader::expectEnd() {
+    expect(Token::End);
+    auto& st = *state_;
+    if(!st.isCbor()) {
+        ::expectEnd(st.in_);
+    }else if(!st.in_.eof()) {
+        ASSERT(false);
+        throw posdk::JsonError("{0}: unexpected data after cbor", pos());
+    }
+}
+
+const std::string_view& posdk::Json::Reader::key() const {
+    return state_->key_;
+}
+
+const posdk::Json::Tree& posdk::Json::Reader::value() const {
+    return state_->value_;
+}
+
+void posdk::Json::Reader::skip() {
+    size_t depth = 0;
+    do {
+        switch(next()) {
+            case Token::BeginObject:
+            case Token::BeginArray:
+                ++depth;
+                break;
+            case Token::EndObject:
+            case Token::EndArray:
+                if(depth == 0) {
+                    throw posdk::JsonError("{0}: no value to skip in json", pos());
+                }
+                --depth;
+                break;
+            case Token::Key:
+            case Token::Value:
+                break;
+            case Token::End:
+                throw posdk::JsonError("{0}: no value to skip in json", pos());
+        }
+    } while(depth > 0);
+}
+
+void posdk::Json::Reader::read(Tree& tree) {
+    auto& st = *state_;
+    if(st.isCbor()) {
+        auto tok = st.cbor_.peek();
+        if((tok != Token::BeginObject) && (tok != Token::BeginArray) && (tok != Token::Value)) {
+            ASSERT(false);
+            throw posdk::JsonError("{0}: no value to read in cbor", pos());
+        }
+        TreeBuilder builder(tree, st.opts_);
+        size_t depth = 0;
+        do {
+            switch(st.cbor_.next(builder)) {
+                case Token::BeginObject:
+                case Token::BeginArray:
+                    ++depth;
+                    break;
+                case Token::EndObject:
+                case Token::EndArray:
+                    --depth;
+                    break;
+                default:
+                    break;
+            }
+        } while(depth > 0);
+        return;
+    }
+    st.prepare();
+    st.ready_ = false;
+    if(st.done_ || st.in_.eof()) {
+        ASSERT(false);
+        throw posdk::JsonError("{0}: unexpected EOF in json", st.in_.pos());
+    }
+    st.beginValue();
+    TreeBuilder builder(tree, st.opts_);
+    parseValue(st.in_, builder);
+    st.endValue();
+}
+
+size_t posdk::Json::Reader::offset() const {
+    return static_cast<size_t>(state_->in_.cur_ - state_->in_.begin_);
+}
+
+std::string posdk::Json::Reader::pos() const {
+    if(state_->isCbor()) {
+        return state_->cbor_.pos();
+    }
+    return state_->in_.pos();
+}
+
+void posdk::Json::Reader::reset(const std::string_view& buf, const size_t& line) {
+    auto& st = *state_;
+    st.in_.begin_ = buf.data();
+    st.in_.end_ = buf.data() + buf.size();
+    st.in_.cur_ = st.in_.begin_;
+    st.in_.row0_ = line;
+    st.in_.col0_ = 1;
+    st.stack_.clear();
+    st.first_ = true;
+    st.afterKey_ = false;
+    st.done_ = false;
+    st.ready_ = false;
+    st.key_ = std::string_view();
+    st.cbor_.stack_.clear();
+    st.cbor_.done_ = false;
+}
+
+struct posdk::Json::LineReader::State {
+    std::string name_;
+    ParseOptions opts_;
+    std::istream* stream_;
+    /// \brief block buffer for a stream, the unread part of the input is [pos_, end_)
+    std::string buf_;
+    const char* pos_;
+    const char* end_;
+    /// \brief row of the last line returned
+    size_t line_;
+    size_t next_;
+    std::unique_ptr<Reader> reader_;
+
+    inline State(const std::string_view& buf, const std::string& name, const ParseOptions& opts, const size_t& firstLine)
+    : name_(name), opts_(opts), stream_(nullptr), pos_(buf.data()), end_(buf.data() + buf.size()), line_(0), next_(firstLine) {}
+
+    inline State(std::istream& in, const std::string& name, const ParseOptions& opts, const size_t& blockSize)
+    : name_(name), opts_(opts), stream_(&in), pos_(nullptr), end_(nullptr), line_(0), next_(1) {
+        opts_.borrowStrings = false;
+        buf_.resize(std::max(blockSize, static_cast<size_t>(1)));
+    }
+
+    /// \brief read the next block after the unread part, false at the end of the stream
+    /// the buffer only grows when a single line does not fit
+    inline bool fill() {
+        if((stream_ == nullptr) || !*stream_) {
+            return false;
+        }
+        auto keep = static_cast<size_t>(end_ - pos_);
+        if(keep > 0) {
+            // pos_ may be the start of buf_ already, hence memmove
+            auto offset = static_cast<size_t>(pos_ - buf_.data());
+            if(keep == buf_.size()) {
+                buf_.resize(buf_.size() * 2);
+            }
+            std::memmove(&buf_[0], buf_.data() + offset, keep);
+        }
+        stream_->read(&buf_[keep], static_cast<std::streamsize>(buf_.size() - keep));
+        auto n = static_cast<size_t>(stream_->gcount());
+        pos_ = buf_.data();
+        end_ = pos_ + keep + n;
+        return (n > 0);
+    }
+
+    inline bool nextLine(std::string_view& line) {
+        for(;;) {
+            auto nl = (pos_ < end_) ? static_cast<const char*>(std::memchr(pos_, '\n', static_cast<size_t>(end_ - pos_))) : nullptr;
+            if((nl == nullptr) && fill()) {
+                continue;
+            }
+            if(pos_ == end_) {
+                return false;
+            }
+            auto e = (nl != nullptr) ? nl : end_;
+            line = std::string_view(pos_, static_cast<size_t>(e - pos_));
+            pos_ = (nl != nullptr) ? (nl + 1) : end_;
+            line_ = next_++;
+            if(!line.empty() && (line.back() == '\r')) {
+                line.remove_suffix(1);
+            }
+            if(!line.empty()) {
+                return true;
+            }
+        }
+    }
+
+    /// \brief parse the next line into handler, false at the end
+    template <typename HandlerT>
+    inline bool parseLine(HandlerT& handler) {
+        std::string_view line;
+        if(!nextLine(line)) {
+            return false;
+        }
+        Tokeniser in(line.data(), line.data() + line.size(), name_, opts_);
+        in.row0_ = line_;
+        parseValue(in, handler);
+        expectEnd(in);
+        return true;
+    }
+};
+
+posdk::Json::LineReader::LineReader(const std::string_view& buf, const std::string& filename, const ParseOptions& opts, const size_t& firstLine) : state_(new State(buf, filename, opts, firstLine)) {}
+
+posdk::Json::LineReader::LineReader(const MappedFile& file, const ParseOptions& opts) : state_(new State(file.view(), file.filename(), opts, 1)) {}
+
+posdk::Json::LineReader::LineReader(std::istream& in, const std::string& filename, const ParseOptions& opts, const size_t& blockSize) : state_(new State(in, filename, opts, blockSize)) {}
+
+posdk::Json::LineReader::~LineReader() {}
+
+bool posdk::Json::LineReader::next(std::string_view& line) {
+    return state_->nextLine(line);
+}
+
+bool posdk::Json::LineReader::next(Tree& tree) {
+    TreeBuilder builder(tree, state_->opts_);
+    return state_->parseLine(builder);
+}
+
+bool posdk::Json::LineReader::next(Handler& handler) {
+    HandlerAdapter adapter(handler);
+    return state_->parseLine(adapter);
+}
+
+posdk::Json::Reader* posdk::Json::LineReader::nextReader() {
+    auto& st = *state_;
+    std::string_view line;
+    if(!st.nextLine(line)) {
+        return nullptr;
+    }
+    if(!st.reader_) {
+        st.reader_.reset(new Reader(line, st.name_, st.opts_));
+    }
+    st.reader_->reset(line, st.line_);
+    return st.reader_.get();
+}
+
+size_t posdk::Json::LineReader::line() const {
+    return state_->line_;
+}
+
+posdk::Json::LineChunks::LineChunks(const std::string_view& buf, const ParallelOptions& opts) : buf_(buf), opts_(opts), threads_(opts.threads) {
+    if(threads_ == 0) {
+        threads_ = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    opts_.chunkSize = std::max(opts_.chunkSize, static_cast<size_t>(1));
+}
+
+namespace {
+    /// \brief runs work(chunk, slot) for count chunks on a pool of threads, then done(slot)
+    /// in chunk order on the calling thread if ordered, otherwise right after work() on
+    /// the same thread. a chunk only starts once the chunk slots before it is done.
+    /// the first exception stops the pool and is left in error, errorChunk is set to
+    /// the chunk if work() threw a JsonError, to count otherwise
+    void runPool(const size_t& count, const size_t& threads, const size_t& slots, const bool& ordered,
+                 const std::function<void(const size_t& chunk, const size_t& slot)>& work,
+                 const std::function<void(const size_t& slot)>& done,
+                 std::exception_ptr& error, size_t& errorChunk) {
+        errorChunk = count;
+        std::mutex mutex;
+        std::condition_variable cv;
+        size_t next = 0;
+        // every chunk below low is done
+        size_t low = 0;
+        std::vector<char> parsed(count, 0);
+        std::vector<char> finished(count, 0);
+
+        auto fail = [&](const size_t& chunk) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if(!error) {
+                error = std::current_exception();
+                errorChunk = chunk;
+            }
+            cv.notify_all();
+        };
+
+        auto worker = [&]() {
+            for(;;) {
+                size_t chunk = 0;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    cv.wait(lock, [&](){ return error || (next == count) || (next < (low + slots)); });
+                    if(error || (next == count)) {
+                        return;
+                    }
+                    chunk = next++;
+                }
+                try {
+                    work(chunk, chunk % slots);
+                }catch(const posdk::JsonError&) {
+                    fail(chunk);
+                    return;
+                }catch(...) {
+                    fail(count);
+                    return;
+                }
+                if(!ordered) {
+                    try {
+                        done(chunk % slots);
+                    }catch(...) {
+                        fail(count);
+                        return;
+                    }
+                }
+                std::lock_guard<std::mutex> lock(mutex);
+                parsed[chunk] = 1;
+                if(!ordered) {
+                    finished[chunk] = 1;
+                    while((low < count) && finished[low]) {
+                        ++low;
+                    }
+                }
+                cv.notify_all();
+            }
+        };
+
+        std::vector<std::thread> pool;
+        for(size_t i = 0; i < std::min(threads, count); ++i) {
+            pool.emplace_back(worker);
+        }
+        if(ordered) {
+            try {
+                for(size_t chunk = 0; chunk < count; ++chunk) {
+                    {
+                        std::unique_lock<std::mutex> lock(mutex);
+                        cv.wait(lock, [&](){ return error || parsed[chunk]; });
+                        if(error) {
+                            break;
+                        }
+                    }
+                    done(chunk % slots);
+                    std::lock_guard<std::mutex> lock(mutex);
+                    low = chunk + 1;
+                    cv.notify_all();
+                }
+            }catch(...) {
+                fail(count);
+            }
+        }
+        for(auto& t : pool) {
+            t.join();
+        }
+    }
+}
+
+void posdk::Json::LineChunks::run(const std::function<void(const size_t& slot, const std::string_view& text, const size_t& firstLine)>& work, const std::function<void(const size_t& slot)>& done) {
+    std::vector<std::string_view> chunks;
+    for(size_t pos = 0; pos < buf_.size();) {
+        auto end = buf_.size();
+        if((buf_.size() - pos) > opts_.chunkSize) {
+            auto from = buf_.data() + pos + opts_.chunkSize - 1;
+            auto nl = static_cast<const char*>(std::memchr(from, '\n', static_cast<size_t>(buf_.data() + buf_.size() - from)));
+            if(nl != nullptr) {
+                end = static_cast<size_t>(nl - buf_.data()) + 1;
+            }
+        }
+        chunks.push_back(buf_.substr(pos, end - pos));
+        pos = end;
+    }
+
+    std::exception_ptr error;
+    auto errorChunk = chunks.size();
+    runPool(chunks.size(), threads_, slots(), opts_.ordered, [&](const size_t& chunk, const size_t& slot) {
+        work(slot, chunks[chunk], 1);
+    }, done, error, errorChunk);
+
+    if(error) {
+        if(errorChunk < chunks.size()) {
+            // parse the chunk again, knowing where it starts, for the right row in the message
+            auto firstLine = 1 + static_cast<size_t>(std::count(buf_.data(), chunks[errorChunk].data(), '\n'));
+            work(0, chunks[errorChunk], firstLine);
+        }
+        std::rethrow_exception(error);
+    }
+}
+
+void posdk::Json::parseLines(const std::string_view& buf, const std::string& filename, const std::function<void(Tree&)>& fn, const ParseOptions& opts, const ParallelOptions& popts) {
+    LineChunks chunks(buf, popts);
+    // an arena and the records parsed into it per slot, reused from chunk to chunk.
+    // a slot's arena is created by its first chunk and sized from it, so small inputs
+    // and unused slots do not pay for a large chunkSize
+    std::vector<std::unique_ptr<Arena>> arenas(chunks.slots());
+    std::vector<std::vector<Tree*>> records(chunks.slots());
+    chunks.run([&](const size_t& slot, const std::string_view& text, const size_t& firstLine) {
+        if(!arenas[slot]) {
+            arenas[slot].reset(new Arena(std::max(2 * text.size(), static_cast<size_t>(4096))));
+        }
+        auto& arena = *arenas[slot];
+        auto& list = records[slot];
+        arena.reset();
+        list.clear();
+        LineReader lines(text, filename, opts, firstLine);
+        auto mr = arena.resource();
+        for(;;) {
+            auto tree = new (mr->allocate(sizeof(Tree), alignof(Tree))) Tree(DataType::Value, mr);
+            if(!lines.next(*tree)) {
+                break;
+            }
+            list.push_back(tree);
+        }
+    }, [&](const size_t& slot) {
+        for(auto tree : records[slot]) {
+            fn(*tree);
+        }
+    });
+}
+
+
+posdk::Json::ArrayChunks::ArrayChunks(const std::string_view& buf, const std::string& filename, const ParseOptions& opts, const ParallelOptions& popts)
+: buf_(buf), filename_(filename), opts_(opts), popts_(popts), threads_(popts.threads) {
+    if(threads_ == 0) {
+        threads_ = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    popts_.chunkSize = std::max(popts_.chunkSize, static_cast<size_t>(1));
+}
+
+bool posdk::Json::ArrayChunks::run(const std::function<void(const size_t& slot, Reader& reader)>& element, const std::function<void(const size_t& slot)>& done) {
+    malformed_ = false;
+    std::vector<std::string_view> chunks;
+    if((opts_.encoding != Encoding::Json) || !splitArray(buf_, popts_.chunkSize, chunks)) {
+        return false;
+    }
+
+    // calls fn with a Reader on each element of a chunk
+    auto elements = [this](const std::string_view& text, const std::function<void(Reader& reader)>& fn) {
+        Reader reader(std::string_view(), filename_, opts_);
+        size_t pos = 0;
+        for(;;) {
+            reader.reset(text.substr(pos));
+            fn(reader);
+            pos += reader.offset();
+            while((pos < text.size()) && isSpace(text[pos])) {
+                ++pos;
+            }
+            if(pos == text.size()) {
+                break;
+            }
+            if(text[pos] != ',') {
+                ASSERT(false);
+                throw posdk::JsonError("{0}: invalid char in json", reader.pos());
+            }
+            ++pos;
+        }
+    };
+
+    std::exception_ptr error;
+    auto errorChunk = chunks.size();
+    runPool(chunks.size(), threads_, slots(), true, [&](const size_t& chunk, const size_t& slot) {
+        elements(chunks[chunk], [&](Reader& reader) {
+            element(slot, reader);
+        });
+    }, done, error, errorChunk);
+
+    if(error) {
+        if(errorChunk < chunks.size()) {
+            // skip the chunk again, an error from element() on well formed text is not a parse error
+            try {
+                elements(chunks[errorChunk], [](Reader& reader) {
+                    reader.skip();
+                });
+            }catch(const posdk::JsonError&) {
+                malformed_ = true;
+            }
+        }
+        std::rethrow_exception(error);
+    }
+    return true;
+}
 
-                        case '.':
-                            n += ch;
-                            in.next();
-                            s = ParserState::EnterNumber1;
-                            break;
+void posdk::Json::loadArray(const std::string_view& buf, const std::string& filename, Tree& tree, const ParseOptions& opts, const ParallelOptions& popts) {
+    // the workers allocate from the default resource, which is thread safe
+    if((tree.resource() != std::pmr::new_delete_resource()) || opts.lazy || (opts.encoding != Encoding::Json)) {
+        return load(buf, filename, tree, opts);
+    }
+    ArrayChunks chunks(buf, filename, opts, popts);
+    std::vector<std::vector<Tree>> elements(chunks.slots());
+    Tree array(DataType::Array);
+    try {
+        auto split = chunks.run([&elements](const size_t& slot, Reader& reader) {
+            elements[slot].emplace_back();
+            reader.read(elements[slot].back());
+        }, [&elements, &array](const size_t& slot) {
+            auto& list = elements[slot];
+            for(auto& e : list) {
+                array.add(std::move(e));
+            }
+            list.clear();
+        });
+        if(!split) {
+            return load(buf, filename, tree, opts);
+        }
+    }catch(const posdk::JsonError&) {
+        // load() throws with the position in the buffer, or reads what the chunks could not
+        load(buf, filename, tree, opts);
+        return;
+    }
+    tree = std::move(array);
+}
 
-                        default:
-                            tree = posdk::Json::Tree(static_cast<int64_t>(std::atol(n.c_str())));
-                            return;
-                    }
-                    break;
+namespace {
+    /// \brief a ValueParser with its handler, behind one interface for PushParser
+    struct PushRunner {
+        virtual ~PushRunner() {}
+        /// \brief run the parser on, true once the value is complete
+        virtual bool run(Tokeniser& in) = 0;
+    };
 
-                case ParserState::EnterNumber1:
-                    switch(ch) {
-                        case '0':
-                        case '1':
-                        case '2':
-                        case '3':
-                        case '4':
-                        case '5':
-                        case '6':
-                        case '7':
-                        case '8':
-                        case '9':
-                            // add to number
-                            n += ch;
-                            in.next();
-                            break;
+    template <typename HandlerT>
+    struct PushRunnerT : public PushRunner {
+        HandlerT handler_;
+        ValueParser<HandlerT> parser_;
 
-                        default:
-                            tree = posdk::Json::Tree(static_cast<float>(std::atof(n.c_str())));
-                            return;
-                    }
-                    break;
-                    
-                case ParserState::EnterString:
-                    switch(ch) {
-                        case '"':
-                            in.next();
-                            tree = posdk::Json::Tree(n);
-                            return;
+        template <typename TargetT>
+        inline PushRunnerT(TargetT& target, const posdk::Json::ParseOptions& opts) : handler_(target, opts), parser_(handler_) {}
 
-                        case '\\':
-                            in.next();
-                            s = ParserState::EnterStringEscape;
-                            break;
+        bool run(Tokeniser& in) override {
+            return parser_.run(in);
+        }
+    };
+}
 
-                        default:
-                            // add to string
-                            in.next();
-                            n += ch;
-                            break;
-                    }
-                    break;
-                    
-                case ParserState::EnterStringEscape:
-                    switch(ch) {
-                        case 'r':
-                            in.next();
-                            break;
-                        case 'n':
-                            n += '\n';
-                            in.next();
-                            break;
-                        default:
-                            in.next();
-                            n += '\\';
-                            n += ch;
-                            break;
-                    }
-                    s = ParserState::EnterString;
-                    break;
+struct posdk::Json::PushParser::State {
+    std::string name_;
+    ParseOptions opts_;
+    std::unique_ptr<PushRunner> runner_;
+    /// \brief unconsumed tail of the previous chunk, a number or escape that may continue
+    std::string carry_;
+    /// \brief position of the next unconsumed byte, for error messages
+    size_t row_;
+    size_t col_;
+    /// \brief the top level value has been read
+    bool done_;
 
-                case ParserState::EnterArray0:
-                    switch(ch) {
-                        case ']':
-                            in.next();
-                            return;
+    /// \brief carry_ is completed from the next chunk this many bytes at a time
+    static constexpr size_t CarryStep = 64;
 
-                        default:
-                            parseValue(in, j);
-                            tree.add(j);
-                            s = ParserState::EnterArray1;
-                            break;
-                    }
-                    break;
-                case ParserState::EnterArray1:
-                    switch(ch) {
-                        case ',':
-                            in.next();
-                            parseValue(in, j);
-                            tree.add(j);
-                            break;
+    template <typename HandlerT, typename TargetT>
+    static inline State* create(TargetT& target, const std::string& name, const ParseOptions& opts) {
+        auto st = new State(name, opts);
+        st->runner_.reset(new PushRunnerT<HandlerT>(target, st->opts_));
+        return st;
+    }
 
-                        case ']':
-                            in.next();
-                            return;
+    inline State(const std::string& name, const ParseOptions& opts) : name_(name), opts_(opts), row_(1), col_(1), done_(false) {
+        opts_.borrowStrings = false;
+    }
 
-                        default:
-                            ASSERT(false);
-                            throw posdk::JsonError("{0}: invalid char in json", in.pos());
-                    }
-                    break;
+    /// \brief parse [begin, end) and return the number of bytes consumed
+    inline size_t step(const char* begin, const char* end, const bool& partial) {
+        Tokeniser in(begin, end, name_, opts_);
+        in.partial_ = partial;
+        in.row0_ = row_;
+        in.col0_ = col_;
+        if(!done_) {
+            done_ = runner_->run(in);
+        }
+        if(done_) {
+            expectEnd(in);
+        }
+        for(auto p = begin; p < in.cur_; ++p) {
+            col_++;
+            if(*p == '\n') {
+                row_++;
+                col_ = 1;
+            }
+        }
+        return static_cast<size_t>(in.cur_ - begin);
+    }
 
-                case ParserState::EnterObjectKey:
-                    switch(ch) {
-                        case '"':
-                            in.next();
-                            k = "";
-                            s = ParserState::EnterObjectKeyString;
-                            break;
+    inline void feed(const char* p, const char* e) {
+        while(!carry_.empty() && (p < e)) {
+            auto old = carry_.size();
+            auto n = std::min(static_cast<size_t>(e - p), CarryStep);
+            carry_.append(p, n);
+            auto used = step(carry_.data(), carry_.data() + carry_.size(), true);
+            if(used >= old) {
+                // the carried token is complete, go on in the chunk itself
+                p += (used - old);
+                carry_.clear();
+            }else{
+                carry_.erase(0, used);
+                p += n;
+            }
+        }
+        if(p < e) {
+            auto used = step(p, e, true);
+            carry_.assign(p + used, e);
+        }
+    }
 
-                        case '}':
-                            in.next();
-                            return;
+    inline void finish() {
+        if(!done_ || !carry_.empty()) {
+            step(carry_.data(), carry_.data() + carry_.size(), false);
+            carry_.clear();
+        }
+    }
+};
 
-                        default:
-                            ASSERT(false);
-                            throw posdk::JsonError("{0}: invalid char in json", in.pos());
-                    }
-                    break;
+posdk::Json::PushParser::PushParser(Handler& handler, const std::string& filename, const ParseOptions& opts) : state_(State::create<HandlerAdapter>(handler, filename, opts)) {}
 
-                case ParserState::EnterObjectKeyString:
-                    switch(ch) {
-                        case '"':
-                            in.next();
-                            s = ParserState::LeaveObjectKeyString;
-                            break;
+posdk::Json::PushParser::PushParser(Tree& tree, const std::string& filename, const ParseOptions& opts) : state_(State::create<TreeBuilder>(tree, filename, opts)) {}
 
-                        default:
-                            // add to key string
-                            k += ch;
-                            in.next();
-                            break;
-                    }
-                    break;
-                    
-                case ParserState::LeaveObjectKeyString:
-                    switch(ch) {
-                        case ':':
-                            in.next();
-                            parseValue(in, j);
-                            tree.add(k, j);
-                            k = "";
-                            s = ParserState::LeaveObjectValue;
-                            break;
-                            
-                        default:
-                            ASSERT(false);
-                            throw posdk::JsonError("{0}: invalid char in json", in.pos());
-                    }
-                    break;
+posdk::Json::PushParser::~PushParser() {}
 
-                case ParserState::LeaveObjectValue:
-                    switch(ch) {
-                        case '}':
-                            in.next();
-                            return;
+posdk::Json::PushParser::Status posdk::Json::PushParser::feed(const char* data, const size_t& size) {
+    state_->feed(data, data + size);
+    return state_->done_ ? Status::Complete : Status::NeedMore;
+}
 
-                        case ',':
-                            in.next();
-                            s = ParserState::EnterObjectKey;
-                            break;
+posdk::Json::PushParser::Status posdk::Json::PushParser::finish() {
+    state_->finish();
+    return Status::Complete;
+}
 
-                        default:
-                            ASSERT(false);
-                            throw posdk::JsonError("{0}: invalid char in json", in.pos());
-                    }
-                    break;
-                case ParserState::TokenTrue_t:
-                    if(ch == 'r'){
-                        in.next();
-                        s = ParserState::TokenTrue_tr;
-                        break;
-                    }
-                    ASSERT(false);
-                    throw posdk::JsonError("{0}: invalid char in json", in.pos());
-                case ParserState::TokenTrue_tr:
-                    if(ch == 'u'){
-                        in.next();
-                        s = ParserState::TokenTrue_tru;
-                        break;
-                    }
-                    ASSERT(false);
-                    throw posdk::JsonError("{0}: invalid char in json", in.pos());
-                case ParserState::TokenTrue_tru:
-                    if(ch == 'e'){
-                        in.next();
-                        tree = posdk::Json::Tree(true);
-                        return;
-                    }
-                    ASSERT(false);
-                    throw posdk::JsonError("{0}: invalid char in json", in.pos());
-                case ParserState::TokenFalse_f:
-                    if(ch == 'a'){
-                        in.next();
-                        s = ParserState::TokenFalse_fa;
-                        break;
-                    }
-                    ASSERT(false);
-                    throw posdk::JsonError("{0}: invalid char in json", in.pos());
-                case ParserState::TokenFalse_fa:
-                    if(ch == 'l'){
-                        in.next();
-                        s = ParserState::TokenFalse_fal;
-                        break;
-                    }
-                    ASSERT(false);
-                    throw posdk::JsonError("{0}: invalid char in json", in.pos());
-                case ParserState::TokenFalse_fal:
-                    if(ch == 's'){
-                        in.next();
-                        s = ParserState::TokenFalse_fals;
-                        break;
-                    }
-                    ASSERT(false);
-                    throw posdk::JsonError("{0}: invalid char in json", in.pos());
-                case ParserState::TokenFalse_fals:
-                    if(ch == 'e'){
-                        in.next();
-                        tree = posdk::Json::Tree(false);
-                        return;
-                    }
-                    ASSERT(false);
-                    throw posdk::JsonError("{0}: invalid char in json", in.pos());
-                case ParserState::TokenNull_n:
-                    if(ch == 'u'){
-                        in.next();
-                        s = ParserState::TokenNull_nu;
-                        break;
-                    }
-                    ASSERT(false);
-                    throw posdk::JsonError("{0}: invalid char in json", in.pos());
-                case ParserState::TokenNull_nu:
-                    if(ch == 'l'){
-                        in.next();
-                        s = ParserState::TokenNull_nul;
-                        break;
-                    }
-                    ASSERT(false);
-                    throw posdk::JsonError("{0}: invalid char in json", in.pos());
-                case ParserState::TokenNull_nul:
-                    if(ch == 'l'){
-                        in.next();
-                        tree = posdk::Json::Tree(posdk::Json::DataType::Value);
-                        return;
-                    }
-                    ASSERT(false);
-                    throw posdk::JsonError("{0}: invalid char in json", in.pos());
-            }
+namespace {
+    /// \brief the array index a reference token stands for, NoIndex unless it is
+    /// "0" or digits without a leading zero that fit a size_t
+    inline size_t arrayIndex(const std::string_view& token) {
+        if(token.empty() || ((token[0] == '0') && (token.size() > 1)) || !std::all_of(token.begin(), token.end(), isDigit)) {
+            return posdk::Json::Path::NoIndex;
         }
+        size_t idx = 0;
+        auto res = std::from_chars(token.data(), token.data() + token.size(), idx);
+        if((res.ec != std::errc()) || (idx == posdk::Json::Path::NoIndex)) {
+            return posdk::Json::Path::NoIndex;
+        }
+        return idx;
+    }
 
-        ASSERT(false);
-        throw posdk::JsonError("{0}: unexpected EOF in json", in.pos());
+    inline bool stepMatches(const posdk::Json::Path::Step& step, const bool& array, const size_t& index, const std::string_view& key) {
+        if(array) {
+            return (step.index == index);
+        }
+        return (!step.key.empty() && (step.key == key));
     }
+}
 
-    struct Print {
-        std::ostream& os_;
-        inline Print(std::ostream& os) : os_(os) {}
-        inline void operator()(const std::nullptr_t&){
-            os_ << "null";
+posdk::Json::Path posdk::Json::Path::pointer(const std::string_view& ptr) {
+    Path path;
+    if(ptr.empty()) {
+        return path;
+    }
+    if(ptr[0] != '/') {
+        throw posdk::JsonError("invalid json pointer:", std::string(ptr));
+    }
+    size_t pos = 1;
+    for(;;) {
+        auto end = std::min(ptr.find('/', pos), ptr.size());
+        Step step;
+        step.key.reserve(end - pos);
+        for(auto i = pos; i < end; ++i) {
+            if(ptr[i] != '~') {
+                step.key += ptr[i];
+                continue;
+            }
+            // ~0 is '~' and ~1 is '/', nothing else may follow a '~'
+            if((i + 1 == end) || ((ptr[i + 1] != '0') && (ptr[i + 1] != '1'))) {
+                throw posdk::JsonError("invalid json pointer:", std::string(ptr));
+            }
+            step.key += (ptr[++i] == '0') ? '~' : '/';
         }
-        inline void operator()(const bool& val){
-            os_ << (val?"true":"false");
+        step.index = arrayIndex(step.key);
+        path.steps_.push_back(std::move(step));
+        if(end == ptr.size()) {
+            return path;
         }
-        inline void operator()(const int64_t& val){
-            os_ << val;
+        pos = end + 1;
+    }
+}
+
+posdk::Json::Path posdk::Json::Path::dotted(const std::string_view& str) {
+    Path path;
+    size_t pos = 0;
+    while(pos < str.size()) {
+        if(str[pos] == '[') {
+            auto close = str.find(']', pos);
+            if(close == std::string_view::npos) {
+                throw posdk::JsonError("invalid json path:", std::string(str));
+            }
+            // an element only, the empty key matches no object member
+            Step step;
+            step.index = arrayIndex(str.substr(pos + 1, close - pos - 1));
+            if(step.index == NoIndex) {
+                throw posdk::JsonError("invalid json path:", std::string(str));
+            }
+            path.steps_.push_back(std::move(step));
+            pos = close + 1;
+        }else{
+            auto end = std::min(str.find_first_of(".[", pos), str.size());
+            if(end == pos) {
+                throw posdk::JsonError("invalid json path:", std::string(str));
+            }
+            Step step;
+            step.key = std::string(str.substr(pos, end - pos));
+            step.index = arrayIndex(step.key);
+            path.steps_.push_back(std::move(step));
+            pos = end;
         }
-        inline void operator()(const float& val){
-            std::ios_base::fmtflags f(os_.flags());
-            os_.precision(8);
-            os_ << std::fixed;
-            os_ << val;
-            os_.flags(f);
+        if((pos < str.size()) && (str[pos] == '.')) {
+            if(++pos == str.size()) {
+                throw posdk::JsonError("invalid json path:", std::string(str));
+            }
+        }else if((pos < str.size()) && (str[pos] != '[')) {
+            throw posdk::JsonError("invalid json path:", std::string(str));
         }
-        inline void operator()(const std::string& val){
-            os_ << "\"";
-            for(auto& ch : val) {
-                switch(ch) {
-                case '\n':
-                    os_ << "\\n";
-                    break;
-                default:
-                    os_ << ch;
-                    break;
-                }
+    }
+    return path;
+}
+
+const posdk::Json::Tree* posdk::Json::Path::find(const Tree& tree) const {
+    auto node = &tree;
+    for(auto& step : steps_) {
+        if(node->isObject()) {
+            // no object holds an empty key
+            if(step.key.empty()) {
+                return nullptr;
+            }
+            node = node->hasChild(step.key);
+            if(node == nullptr) {
+                return nullptr;
             }
-            os_ << "\"";
+        }else if(node->isArray()) {
+            if(step.index >= node->size()) {
+                return nullptr;
+            }
+            node = &node->at(step.index);
+        }else{
+            return nullptr;
         }
-    };
+    }
+    return node;
 }
 
-std::map<std::string, posdk::Json::Tree*>::const_iterator posdk::Json::Tree::find(const std::string& key) const {
-    auto vit = names.find(key);
-    if(vit == names.end()){
-        throw posdk::JsonError("json key not found:" + key);
+const posdk::Json::Tree& posdk::Json::Path::get(const Tree& tree) const {
+    auto node = find(tree);
+    if(node == nullptr) {
+        std::string ptr;
+        for(auto& step : steps_) {
+            ptr += '/';
+            ptr += step.key.empty() ? std::to_string(step.index) : step.key;
+        }
+        throw posdk::JsonError("json path not found:", ptr);
     }
-    return vit;
+    return *node;
 }
 
-void posdk::Json::Tree::print(std::ostream& os, const size_t& lvl, const size_t& indent) const {
-    std::string sep;
-    std::string nsep = ",\n";
-    std::string nl = "\n";
-    std::string indent1(lvl*2, ' ');
-    std::string indent2((lvl+1)*2, ' ');
-
-    if(indent == 0){
-        indent1 = "";
-        indent2 = "";
-        nsep = ",";
-        nl = "";
+struct posdk::Json::PathSelector::State {
+    /// \brief an open container and the paths that matched every level down to it
+    struct Frame {
+        bool array;
+        size_t index;
+        std::string key;
+        std::vector<size_t> alive;
+    };
+
+    std::vector<Path> paths_;
+    std::vector<Tree> results_;
+    std::vector<bool> found_;
+    ParseOptions opts_;
+    std::vector<TreeBuilder> builders_;
+    /// \brief depth at which each active capture began
+    std::vector<size_t> level_;
+    std::vector<size_t> active_;
+    /// \brief frames_ is never shrunk, so the keys keep their capacity between containers
+    std::vector<Frame> frames_;
+    size_t depth_;
+    std::vector<size_t> matched_;
+
+    inline State(const std::vector<Path>& paths) : paths_(paths), results_(paths.size()), found_(paths.size(), false), level_(paths.size(), 0), depth_(0) {
+        builders_.reserve(paths.size());
+        for(auto& r : results_) {
+            builders_.emplace_back(r, opts_);
+        }
     }
-    switch(dataType_){
-    case DataType::Object:
-        if(items_.size() == 0){
-            os << "{}";
-            break;
+
+    /// \brief a value starts at the current depth, start the captures it completes
+    /// and collect in matched_ the paths that go on below it
+    inline void begin(const bool& container) {
+        matched_.clear();
+        if(depth_ == 0) {
+            std::fill(found_.begin(), found_.end(), false);
+            for(size_t p = 0; p < paths_.size(); ++p) {
+                startOrDescend(p, container);
+            }
+            return;
         }
-        os << "{" << nl;
-        for(auto& p : items_){
-            os << sep << indent2;
-            os << "\"" << p.first << "\":";
-            p.second.print(os, lvl + 1, indent);
-            sep = nsep;
+        auto& frame = frames_[depth_ - 1];
+        for(auto p : frame.alive) {
+            if(stepMatches(paths_[p].steps()[depth_ - 1], frame.array, frame.index, frame.key)) {
+                // like Tree, the last of duplicate keys wins
+                found_[p] = false;
+                startOrDescend(p, container);
+            }
         }
-        os << nl << indent1 << "}";
-        break;
-    case DataType::Array:
-        if(items_.size() == 0){
-            os << "[]";
-            break;
+    }
+
+    inline void startOrDescend(const size_t& p, const bool& container) {
+        if(paths_[p].steps().size() == depth_) {
+            found_[p] = true;
+            level_[p] = depth_;
+            active_.push_back(p);
+        }else if(container) {
+            matched_.push_back(p);
         }
-        os << "[" << nl;
-        for(auto& p : items_){
-            os << sep << indent2;
-            p.second.print(os, lvl + 1, indent);
-            sep = nsep;
+    }
+
+    inline void push(const bool& array) {
+        if(frames_.size() == depth_) {
+            frames_.emplace_back();
+        }
+        auto& frame = frames_[depth_++];
+        frame.array = array;
+        frame.index = 0;
+        frame.alive.swap(matched_);
+    }
+
+    /// \brief a value ended at the current depth, finish its captures and move to the next element
+    inline void end() {
+        while(!active_.empty() && (level_[active_.back()] == depth_)) {
+            active_.pop_back();
+        }
+        if(depth_ > 0) {
+            ++frames_[depth_ - 1].index;
+        }
+    }
+
+    template <typename FnT>
+    inline void forward(FnT&& fn) {
+        for(auto p : active_) {
+            fn(builders_[p]);
         }
-        os << nl << indent1 << "]";
-        break;
-    case DataType::Value:
-        std::visit(Print(os), value);
-        break;
     }
+
+    template <typename ValT>
+    inline void scalar(const ValT& val) {
+        begin(false);
+        forward([&val](TreeBuilder& b){ b.value(val); });
+        end();
+    }
+};
+
+posdk::Json::PathSelector::PathSelector(const std::vector<Path>& paths) : state_(new State(paths)) {}
+
+posdk::Json::PathSelector::~PathSelector() {}
+
+const posdk::Json::Tree* posdk::Json::PathSelector::result(const size_t& idx) const {
+    return state_->found_.at(idx) ? &state_->results_[idx] : nullptr;
 }
 
-void posdk::Json::load(std::istream& in, const std::string& filename, posdk::Json::Tree& tree) {
-    Tokeniser tok(in, filename);
-    return parseValue(tok, tree);
+void posdk::Json::PathSelector::beginObject() {
+    auto& st = *state_;
+    st.begin(true);
+    st.forward([](TreeBuilder& b){ b.beginObject(); });
+    st.push(false);
 }
 
-posdk::Json::Tree posdk::Json::loadFromString(const std::string& str) {
-    posdk::Json::Tree tree(posdk::Json::DataType::Value);
-    if(str.size() == 0) {
-        return tree;
-    }
+void posdk::Json::PathSelector::endObject() {
+    auto& st = *state_;
+    st.forward([](TreeBuilder& b){ b.endObject(); });
+    --st.depth_;
+    st.end();
+}
 
-    std::istringstream iss(str);
-    load(iss, "<str>", tree);
-    return tree;
+void posdk::Json::PathSelector::beginArray() {
+    auto& st = *state_;
+    st.begin(true);
+    st.forward([](TreeBuilder& b){ b.beginArray(); });
+    st.push(true);
 }
 
-std::string posdk::Json::saveToString(const Tree& tree, const size_t& indent) {
-    std::ostringstream oss;
-    save(oss, tree, indent);
-    return oss.str();
+void posdk::Json::PathSelector::endArray() {
+    auto& st = *state_;
+    st.forward([](TreeBuilder& b){ b.endArray(); });
+    --st.depth_;
+    st.end();
 }
 
-posdk::Json::Tree posdk::Json::loadFromFile(const std::string& filename) {
-    posdk::Json::Tree tree(posdk::Json::DataType::Value);
-    std::ifstream ifs(filename);
-    if(!ifs) {
-        throw posdk::JsonError("file not found:" + filename);
-    }
-    load(ifs, filename, tree);
-    return tree;
+void posdk::Json::PathSelector::key(const std::string_view& key) {
+    auto& st = *state_;
+    auto& frame = st.frames_[st.depth_ - 1];
+    frame.key.assign(key.data(), key.size());
+    st.forward([&frame](TreeBuilder& b){ b.key(frame.key, false); });
 }
 
-void posdk::Json::saveToFile(const Tree& tree, const std::string& filename, const size_t& indent) {
-    std::ofstream ofs(filename);
-    save(ofs, tree, indent);
+void posdk::Json::PathSelector::null() {
+    auto& st = *state_;
+    st.begin(false);
+    st.forward([](TreeBuilder& b){ b.null(); });
+    st.end();
+}
+
+void posdk::Json::PathSelector::value(const bool_t& val) {
+    state_->scalar(val);
+}
+
+void posdk::Json::PathSelector::value(const integer_t& val) {
+    state_->scalar(val);
+}
+
+void posdk::Json::PathSelector::value(const uinteger_t& val) {
+    state_->scalar(val);
+}
+
+void posdk::Json::PathSelector::value(const float_t& val) {
+    state_->scalar(val);
+}
+
+void posdk::Json::PathSelector::value(const std::string_view& val) {
+    auto& st = *state_;
+    st.begin(false);
+    st.forward([&val](TreeBuilder& b){ b.value(val, false); });
+    st.end();
 }
 
 enum class CodecState {
@@ -678,3 +3733,70 @@ std::string posdk::Json::encodeString(const std::string& str) {
     }
     return estr;
 }
+
+std::string posdk::Json::encodeBase64(const char* data, const size_t& size) {
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string str;
+    str.resize(((size + 2) / 3) * 4);
+    auto in = reinterpret_cast<const unsigned char*>(data);
+    auto out = &str[0];
+    size_t i = 0;
+    for(; (i + 3) <= size; i += 3) {
+        uint32_t n = (static_cast<uint32_t>(in[i]) << 16) | (static_cast<uint32_t>(in[i + 1]) << 8) | in[i + 2];
+        *out++ = alphabet[(n >> 18) & 0x3f];
+        *out++ = alphabet[(n >> 12) & 0x3f];
+        *out++ = alphabet[(n >> 6) & 0x3f];
+        *out++ = alphabet[n & 0x3f];
+    }
+    if(i < size) {
+        uint32_t n = static_cast<uint32_t>(in[i]) << 16;
+        if((i + 1) < size) {
+            n |= static_cast<uint32_t>(in[i + 1]) << 8;
+        }
+        *out++ = alphabet[(n >> 18) & 0x3f];
+        *out++ = alphabet[(n >> 12) & 0x3f];
+        *out++ = ((i + 1) < size) ? alphabet[(n >> 6) & 0x3f] : '=';
+        *out++ = '=';
+    }
+    return str;
+}
+
+std::string posdk::Json::decodeBase64(const std::string_view& str) {
+    // 0xff marks bytes outside the alphabet
+    static const auto table = [](){
+        std::array<uint8_t, 256> t;
+        t.fill(0xff);
+        const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        for(uint8_t i = 0; i < 64; ++i) {
+            t[static_cast<unsigned char>(alphabet[i])] = i;
+        }
+        return t;
+    }();
+    if((str.size() % 4) != 0) {
+        throw posdk::JsonError("invalid base64 length:", std::to_string(str.size()));
+    }
+    size_t pad = 0;
+    if((str.size() > 0) && (str[str.size() - 1] == '=')) {
+        pad = (str[str.size() - 2] == '=') ? 2 : 1;
+    }
+    std::string bytes;
+    bytes.resize(((str.size() / 4) * 3) - pad);
+    auto out = &bytes[0];
+    auto in = reinterpret_cast<const unsigned char*>(str.data());
+    auto len = str.size() - pad;
+    uint32_t n = 0;
+    size_t bits = 0;
+    for(size_t i = 0; i < len; ++i) {
+        auto v = table[in[i]];
+        if(v == 0xff) {
+            throw posdk::JsonError("invalid char in base64 at:", std::to_string(i));
+        }
+        n = (n << 6) | v;
+        bits += 6;
+        if(bits >= 8) {
+            bits -= 8;
+            *out++ = static_cast<char>((n >> bits) & 0xff);
+        }
+    }
+    return bytes;
+}
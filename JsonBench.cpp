@@ -0,0 +1,874 @@
+#include "JsonSerialiser.hpp"
+#include <chrono>
+#include <thread>
+#include <charconv>
+
+namespace {
+    /// \brief run fn iterations times, return average milliseconds per run
+    template <typename FnT>
+    inline double timeit(const size_t& iterations, FnT&& fn) {
+        auto start = std::chrono::steady_clock::now();
+        for(size_t i = 0; i < iterations; ++i) {
+            fn();
+        }
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::milli>(end - start).count() / static_cast<double>(iterations);
+    }
+
+    /// \brief the ostream printer saveToString used before the Writer, for comparison
+    void legacyPrint(std::ostream& os, const posdk::Json::Tree& tree, const size_t& lvl, const size_t& indent) {
+        std::string sep;
+        std::string nsep = ",\n";
+        std::string nl = "\n";
+        std::string indent1(lvl*2, ' ');
+        std::string indent2((lvl+1)*2, ' ');
+
+        if(indent == 0){
+            indent1 = "";
+            indent2 = "";
+            nsep = ",";
+            nl = "";
+        }
+        if(tree.isObject()){
+            if(tree.size() == 0){
+                os << "{}";
+                return;
+            }
+            os << "{" << nl;
+            for(auto& p : tree){
+                os << sep << indent2;
+                os << "\"" << p.first << "\":";
+                legacyPrint(os, p.second, lvl + 1, indent);
+                sep = nsep;
+            }
+            os << nl << indent1 << "}";
+        }else if(tree.isArray()){
+            if(tree.size() == 0){
+                os << "[]";
+                return;
+            }
+            os << "[" << nl;
+            for(size_t i = 0; i < tree.size(); ++i){
+                os << sep << indent2;
+                legacyPrint(os, tree.at(i), lvl + 1, indent);
+                sep = nsep;
+            }
+            os << nl << indent1 << "]";
+        }else if(tree.isValue<bool>()){
+            os << (tree.getValue<bool>()?"true":"false");
+        }else if(tree.isValue<int64_t>()){
+            os << tree.getValue<int64_t>();
+        }else if(tree.isValue<double>()){
+            std::ios_base::fmtflags f(os.flags());
+            os.precision(8);
+            os << std::fixed;
+            os << tree.getValue<double>();
+            os.flags(f);
+        }else if(tree.isValue<std::string>()){
+            os << "\"";
+            for(auto& ch : tree.getStringView()) {
+                switch(ch) {
+                case '\n':
+                    os << "\\n";
+                    break;
+                default:
+                    os << ch;
+                    break;
+                }
+            }
+            os << "\"";
+        }else{
+            os << "null";
+        }
+    }
+}
+
+int bench_deep_nesting() {
+    for(size_t depth : {250, 500, 1000, 2000, 4000}) {
+        std::string str;
+        for(size_t i = 0; i < depth; ++i) {
+            str += "{\"a\":[";
+        }
+        str += "1";
+        for(size_t i = 0; i < depth; ++i) {
+            str += "]}";
+        }
+
+        auto ms = timeit(5, [&str](){
+            auto tree = posdk::Json::loadFromString(str);
+        });
+        std::cout << "deep-nesting depth:" << depth << " parse-ms:" << ms << std::endl;
+    }
+    return 0;
+}
+
+int bench_numeric_array() {
+    std::string str = "[";
+    for(size_t i = 0; i < 1000000; ++i) {
+        if(i > 0) {
+            str += ",";
+        }
+        str += std::to_string(i);
+    }
+    str += "]";
+
+    posdk::Json::Tree tree;
+    auto pms = timeit(1, [&str, &tree](){
+        tree = posdk::Json::loadFromString(str);
+    });
+
+    int64_t sum = 0;
+    auto ims = timeit(10, [&tree, &sum](){
+        for(auto& p : tree) {
+            sum += p.second.getValue<int64_t>();
+        }
+    });
+    std::cout << "numeric-array count:" << tree.size() << " sizeof(Tree):" << sizeof(posdk::Json::Tree) << " parse-ms:" << pms << " iterate-ms:" << ims << " sum:" << sum << std::endl;
+    return 0;
+}
+
+/// \brief a request-sized document with many small keys and strings
+std::string makeRecords(const size_t& count) {
+    std::string str = "[";
+    for(size_t i = 0; i < count; ++i) {
+        if(i > 0) {
+            str += ",";
+        }
+        str += "{\"id\":" + std::to_string(i) + ",\"name\":\"user" + std::to_string(i) + "\",\"active\":true,\"tags\":[\"a\",\"b\"],\"score\":1.5}";
+    }
+    str += "]";
+    return str;
+}
+
+int bench_arena() {
+    auto str = makeRecords(2000);
+
+    auto hms = timeit(50, [&str](){
+        auto tree = posdk::Json::loadFromString(str);
+    });
+
+    posdk::Json::Arena arena(4 * 1024 * 1024);
+    auto ams = timeit(50, [&str, &arena](){
+        auto& tree = posdk::Json::loadFromString(str, arena);
+        (void)tree;
+        arena.reset();
+    });
+    std::cout << "records bytes:" << str.size() << " heap-parse+free-ms:" << hms << " arena-parse+reset-ms:" << ams << std::endl;
+    return 0;
+}
+
+int bench_borrow() {
+    auto str = makeRecords(2000);
+
+    auto cms = timeit(50, [&str](){
+        auto tree = posdk::Json::loadFromString(str);
+    });
+
+    posdk::Json::ParseOptions opts;
+    opts.borrowStrings = true;
+    auto bms = timeit(50, [&str, &opts](){
+        auto tree = posdk::Json::loadFromString(str, opts);
+    });
+    std::cout << "records bytes:" << str.size() << " copy-strings-ms:" << cms << " borrow-strings-ms:" << bms << std::endl;
+    return 0;
+}
+
+int bench_strings() {
+    // base64-ish blobs and free text with an occasional escape
+    std::string str = "[";
+    for(size_t i = 0; i < 2000; ++i) {
+        if(i > 0) {
+            str += ",";
+        }
+        std::string blob;
+        for(size_t j = 0; j < 1024; ++j) {
+            blob += "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/"[(i * 31 + j * 7) % 64];
+        }
+        str += "{\"blob\":\"" + blob + "\",\"text\":\"the quick brown fox jumps over the lazy dog\\nagain and again\"}";
+    }
+    str += "]";
+
+    auto ms = timeit(20, [&str](){
+        auto tree = posdk::Json::loadFromString(str);
+    });
+    std::cout << "strings bytes:" << str.size() << " parse-ms:" << ms << " MB/s:" << (static_cast<double>(str.size()) / 1e3 / ms) << std::endl;
+    return 0;
+}
+
+int bench_structural() {
+    // the library's own pretty-printed output is a good share whitespace
+    auto str = posdk::Json::saveToString(posdk::Json::loadFromString(makeRecords(5000)), 2);
+
+    auto sms = timeit(20, [&str](){
+        auto tree = posdk::Json::loadFromString(str);
+    });
+
+    posdk::Json::ParseOptions opts;
+    opts.structuralIndex = true;
+    auto ims = timeit(20, [&str, &opts](){
+        auto tree = posdk::Json::loadFromString(str, opts);
+    });
+    std::cout << "indented bytes:" << str.size() << " state-machine-ms:" << sms << " structural-index-ms:" << ims << std::endl;
+    return 0;
+}
+
+int bench_lookup() {
+    static const char* keys[] = {
+        "ChannelID", "Record", "Creator", "UserID", "DocumentID", "Reply", "value", "Text",
+        "Action", "timestamp", "sequence", "status", "origin", "target", "payload", "checksum",
+        "version", "flags", "session", "region", "latency", "attempts", "priority", "deadline",
+        "owner", "group", "parent", "children", "created", "updated",
+    };
+    for(size_t count : {5, 15, 30}) {
+        posdk::Json::Tree tree(posdk::Json::DataType::Object);
+        for(size_t i = 0; i < count; ++i) {
+            tree.add(keys[i], static_cast<posdk::Json::integer_t>(i));
+        }
+
+        size_t found = 0;
+        auto ms = timeit(100000, [&tree, &found, &count](){
+            for(size_t i = 0; i < count; ++i) {
+                if(tree.hasChild(keys[i]) != nullptr) {
+                    ++found;
+                }
+            }
+        });
+        std::cout << "lookup keys:" << count << " ns-per-lookup:" << (ms * 1e6 / static_cast<double>(count)) << " found:" << found << std::endl;
+    }
+    return 0;
+}
+
+int bench_numbers() {
+    std::vector<std::string> tokens;
+    std::string str = "[";
+    for(size_t i = 0; i < 1000000; ++i) {
+        std::string n;
+        switch(i % 4) {
+            case 0: n = std::to_string(static_cast<int64_t>(i * 7919) - 3000000); break;
+            case 1: n = std::to_string(i * 2654435761ULL); break;
+            case 2: n = std::to_string(static_cast<double>(i) / 7.0); break;
+            default: n = std::to_string(i % 1000) + ".25e-" + std::to_string(i % 20); break;
+        }
+        if(i > 0) {
+            str += ",";
+        }
+        str += n;
+        tokens.push_back(std::move(n));
+    }
+    str += "]";
+
+    auto pms = timeit(5, [&str](){
+        auto tree = posdk::Json::loadFromString(str);
+    });
+    std::cout << "numbers bytes:" << str.size() << " parse-ms:" << pms << " MB/s:" << (static_cast<double>(str.size()) / 1000.0 / pms) << std::endl;
+
+    // token level: the old copy + atol/atof against from_chars on the input range
+    double sum = 0;
+    auto ams = timeit(5, [&tokens, &sum](){
+        for(auto& t : tokens) {
+            std::string n(t.data(), t.size());
+            if(n.find_first_of(".eE") != std::string::npos) {
+                sum += std::atof(n.c_str());
+            }else{
+                sum += static_cast<double>(std::atol(n.c_str()));
+            }
+        }
+    });
+    auto fms = timeit(5, [&tokens, &sum](){
+        for(auto& t : tokens) {
+            auto end = t.data() + t.size();
+            if(t.find_first_of(".eE") != std::string::npos) {
+                double d = 0;
+                std::from_chars(t.data(), end, d);
+                sum += d;
+            }else{
+                int64_t v = 0;
+                std::from_chars(t.data(), end, v);
+                sum += static_cast<double>(v);
+            }
+        }
+    });
+    std::cout << "numbers tokens:" << tokens.size() << " atol-atof-ms:" << ams << " from_chars-ms:" << fms << " sum:" << sum << std::endl;
+    return 0;
+}
+
+int bench_serialise() {
+    auto tree = posdk::Json::loadFromString(makeRecords(100000));
+    for(size_t indent : {0, 2}) {
+        size_t bytes = 0;
+        auto pms = timeit(5, [&tree, &indent, &bytes](){
+            std::ostringstream oss;
+            legacyPrint(oss, tree, 0, indent);
+            bytes = oss.str().size();
+        });
+        auto sms = timeit(5, [&tree, &indent](){
+            auto str = posdk::Json::saveToString(tree, indent);
+        });
+        posdk::Json::Writer writer(indent);
+        auto wms = timeit(5, [&tree, &writer](){
+            writer.clear();
+            writer.value(tree);
+        });
+        std::cout << "serialise indent:" << indent << " bytes:" << bytes << " print-ms:" << pms << " saveToString-ms:" << sms << " reused-writer-ms:" << wms << std::endl;
+    }
+    return 0;
+}
+
+int bench_serialise_numbers() {
+    posdk::Json::Tree ints(posdk::Json::DataType::Array);
+    posdk::Json::Tree floats(posdk::Json::DataType::Array);
+    posdk::Json::Tree prices(posdk::Json::DataType::Array);
+    for(size_t i = 0; i < 1000000; ++i) {
+        ints.add(posdk::Json::Tree(static_cast<int64_t>(i * 2654435761ULL % 100000000000ULL) - 50000000000LL));
+        floats.add(posdk::Json::Tree(static_cast<double>(i) / 7.0));
+        prices.add(posdk::Json::Tree(static_cast<double>(i % 100000) / 100.0));
+    }
+    for(auto tree : {&ints, &floats, &prices}) {
+        size_t pbytes = 0;
+        auto pms = timeit(3, [&tree, &pbytes](){
+            std::ostringstream oss;
+            legacyPrint(oss, *tree, 0, 0);
+            pbytes = oss.str().size();
+        });
+        size_t sbytes = 0;
+        auto sms = timeit(3, [&tree, &sbytes](){
+            sbytes = posdk::Json::saveToString(*tree, 0).size();
+        });
+        std::cout << "serialise-numbers " << (tree == &ints ? "int64" : (tree == &floats ? "double" : "price")) << " print-ms:" << pms << " print-bytes:" << pbytes << " saveToString-ms:" << sms << " bytes:" << sbytes << std::endl;
+    }
+    return 0;
+}
+
+int bench_serialise_strings() {
+    posdk::Json::Tree tree(posdk::Json::DataType::Array);
+    for(size_t i = 0; i < 100000; ++i) {
+        std::string str = "message " + std::to_string(i) + ": the quick brown fox jumps over the lazy dog, twice over, then stops for a rest";
+        if(i % 10 == 0) {
+            str += " \"quoted\"\tand\\escaped\n";
+        }
+        tree.add(str);
+    }
+    size_t bytes = 0;
+    auto pms = timeit(5, [&tree](){
+        std::ostringstream oss;
+        legacyPrint(oss, tree, 0, 0);
+    });
+    auto sms = timeit(5, [&tree, &bytes](){
+        bytes = posdk::Json::saveToString(tree, 0).size();
+    });
+    std::cout << "serialise-strings bytes:" << bytes << " print-ms:" << pms << " saveToString-ms:" << sms << " MB/s:" << (static_cast<double>(bytes) / 1000.0 / sms) << std::endl;
+    return 0;
+}
+
+struct BenchRecord {
+    int64_t id = 0;
+    std::string name;
+    bool active = true;
+    std::vector<std::string> tags = {"a", "b"};
+    double score = 1.5;
+
+    inline BenchRecord() {}
+
+    inline BenchRecord(const posdk::Json::Tree& jobj)
+    : id(jget(jobj, "id", id))
+    , name(jget(jobj, "name", name))
+    , active(jget(jobj, "active", active))
+    , tags(jget(jobj, "tags", tags))
+    , score(jget(jobj, "score", score))
+    {}
+
+    inline bool jload(posdk::Json::Reader& reader, const std::string_view& key) {
+        if(key == "id") return jget(reader, id);
+        if(key == "name") return jget(reader, name);
+        if(key == "active") return jget(reader, active);
+        if(key == "tags") return jget(reader, tags);
+        if(key == "score") return jget(reader, score);
+        return false;
+    }
+
+    inline void jsave(posdk::Json::Tree& jobj) const {
+        jset(jobj, "id", id);
+        jset(jobj, "name", name);
+        jset(jobj, "active", active);
+        jset(jobj, "tags", tags);
+        jset(jobj, "score", score);
+    }
+
+    inline void jsave(posdk::Json::Writer& writer) const {
+        jset(writer, "id", id);
+        jset(writer, "name", name);
+        jset(writer, "active", active);
+        jset(writer, "tags", tags);
+        jset(writer, "score", score);
+    }
+};
+
+int bench_serialiser_writer() {
+    std::vector<int> ints(1000000);
+    for(size_t i = 0; i < ints.size(); ++i) {
+        ints[i] = static_cast<int>(i);
+    }
+    std::vector<BenchRecord> records(100000);
+    for(size_t i = 0; i < records.size(); ++i) {
+        records[i].id = static_cast<int64_t>(i);
+        records[i].name = "user" + std::to_string(i);
+    }
+
+    auto tint = timeit(5, [&ints](){
+        auto str = posdk::Json::saveToString(posdk::Json::v2j(ints), 0);
+    });
+    posdk::Json::Writer writer(0);
+    auto wint = timeit(5, [&ints, &writer](){
+        writer.clear();
+        posdk::Json::v2j(writer, ints);
+    });
+    auto trec = timeit(5, [&records](){
+        auto str = posdk::Json::saveToString(posdk::Json::v2j(records), 0);
+    });
+    auto wrec = timeit(5, [&records, &writer](){
+        writer.clear();
+        posdk::Json::v2j(writer, records);
+    });
+    std::cout << "serialiser vector<int>:" << ints.size() << " tree-ms:" << tint << " writer-ms:" << wint
+              << " records:" << records.size() << " tree-ms:" << trec << " writer-ms:" << wrec << std::endl;
+    return 0;
+}
+
+int bench_deserialiser_reader() {
+    auto str = makeRecords(100000);
+    size_t count = 0;
+    auto tms = timeit(5, [&str, &count](){
+        auto records = posdk::Json::j2v<std::vector<BenchRecord>>(posdk::Json::loadFromString(str));
+        count = records.size();
+    });
+    auto rms = timeit(5, [&str, &count](){
+        posdk::Json::Reader reader(str);
+        auto records = posdk::Json::j2v<std::vector<BenchRecord>>(reader);
+        count = records.size();
+    });
+    std::cout << "deserialiser records:" << count << " tree-ms:" << tms << " reader-ms:" << rms << std::endl;
+    return 0;
+}
+
+/// \brief sums the "id" field of every record without building a Tree
+struct SumIdHandler : public posdk::Json::Handler {
+    bool isId = false;
+    int64_t sum = 0;
+    void key(const std::string_view& k) override { isId = (k == "id"); }
+    void value(const posdk::Json::integer_t& v) override {
+        if(isId) {
+            sum += v;
+        }
+    }
+};
+
+int bench_sax() {
+    auto str = makeRecords(100000);
+    int64_t tsum = 0;
+    auto tms = timeit(5, [&str, &tsum](){
+        auto tree = posdk::Json::loadFromString(str);
+        tsum = 0;
+        for(size_t i = 0; i < tree.size(); ++i) {
+            tsum += tree.at(i).getChild("id").getValue<int64_t>();
+        }
+    });
+    int64_t hsum = 0;
+    auto hms = timeit(5, [&str, &hsum](){
+        SumIdHandler handler;
+        posdk::Json::parse(str, "bench", handler);
+        hsum = handler.sum;
+    });
+    std::cout << "sax records bytes:" << str.size() << " tree-ms:" << tms << " handler-ms:" << hms << " sum:" << tsum << "/" << hsum << std::endl;
+    return 0;
+}
+
+int bench_push() {
+    auto str = makeRecords(100000);
+    auto lms = timeit(5, [&str](){
+        auto tree = posdk::Json::loadFromString(str);
+    });
+    std::cout << "push records bytes:" << str.size() << " whole-buffer-ms:" << lms;
+    for(auto chunk : {size_t(1500), size_t(65536)}) {
+        auto cms = timeit(5, [&str, chunk](){
+            posdk::Json::Tree tree;
+            posdk::Json::PushParser parser(tree);
+            for(size_t i = 0; i < str.size(); i += chunk) {
+                parser.feed(str.data() + i, std::min(chunk, str.size() - i));
+            }
+            parser.finish();
+        });
+        std::cout << " chunk-" << chunk << "-ms:" << cms;
+    }
+
+    // how much of the body has to arrive before the first record field is seen
+    SumIdHandler handler;
+    posdk::Json::PushParser parser(handler);
+    size_t fed = 0;
+    while(handler.sum == 0) {
+        parser.feed(str.data() + fed, 1500);
+        fed += 1500;
+    }
+    std::cout << " first-field-bytes:" << fed << std::endl;
+    return 0;
+}
+
+int bench_lines() {
+    std::vector<BenchRecord> records(200000);
+    for(size_t i = 0; i < records.size(); ++i) {
+        records[i].id = static_cast<int64_t>(i);
+        records[i].name = "user" + std::to_string(i);
+    }
+
+    std::string str;
+    auto sms = timeit(3, [&records, &str](){
+        std::ostringstream os;
+        for(auto& rec : records) {
+            os << posdk::Json::saveToString(posdk::Json::v2j(rec), 0) << "\n";
+        }
+        str = os.str();
+    });
+    auto wms = timeit(3, [&records, &str](){
+        std::ostringstream os;
+        posdk::Json::OstreamSink sink(os);
+        posdk::Json::Writer writer(sink, 0);
+        for(auto& rec : records) {
+            posdk::Json::jline(writer, rec);
+        }
+        writer.flush();
+        str = os.str();
+    });
+
+    size_t count = 0;
+    auto gms = timeit(3, [&str, &count](){
+        std::istringstream is(str);
+        std::string line;
+        count = 0;
+        while(std::getline(is, line)) {
+            auto rec = posdk::Json::j2v<BenchRecord>(posdk::Json::loadFromString(line));
+            ++count;
+        }
+    });
+    auto tms = timeit(3, [&str, &count](){
+        std::istringstream is(str);
+        posdk::Json::LineReader lines(is);
+        posdk::Json::Tree tree;
+        count = 0;
+        while(lines.next(tree)) {
+            ++count;
+        }
+    });
+    auto rms = timeit(3, [&str, &count](){
+        std::istringstream is(str);
+        posdk::Json::LineReader lines(is);
+        BenchRecord rec;
+        count = 0;
+        while(posdk::Json::jnext(lines, rec)) {
+            ++count;
+        }
+    });
+    std::cout << "ndjson records:" << count << " bytes:" << str.size() << " write-tree-ms:" << sms << " write-lines-ms:" << wms
+              << " read-getline-ms:" << gms << " read-tree-ms:" << tms << " read-jnext-ms:" << rms << std::endl;
+    return 0;
+}
+
+int bench_parallel_lines() {
+    std::ostringstream os;
+    posdk::Json::OstreamSink sink(os);
+    posdk::Json::Writer writer(sink, 0);
+    BenchRecord rec;
+    for(int64_t i = 0; i < 400000; ++i) {
+        rec.id = i;
+        rec.name = "user" + std::to_string(i);
+        posdk::Json::jline(writer, rec);
+    }
+    writer.flush();
+    auto str = os.str();
+
+    std::cout << "parallel-ndjson bytes:" << str.size() << " cores:" << std::thread::hardware_concurrency();
+    for(size_t threads : {size_t(1), size_t(2), size_t(4), size_t(8)}) {
+        posdk::Json::ParallelOptions popts;
+        popts.threads = threads;
+        int64_t sum = 0;
+        auto tms = timeit(3, [&str, &popts, &sum](){
+            sum = 0;
+            posdk::Json::parseLines(str, "bench", [&sum](posdk::Json::Tree& tree){
+                sum += tree.getChild("id").getValue<int64_t>();
+            }, posdk::Json::ParseOptions(), popts);
+        });
+        auto jms = timeit(3, [&str, &popts, &sum](){
+            sum = 0;
+            posdk::Json::j2vLines<BenchRecord>(str, "bench", [&sum](BenchRecord& r){
+                sum += r.id;
+            }, posdk::Json::ParseOptions(), popts);
+        });
+        std::cout << " threads-" << threads << "-tree-ms:" << tms << " j2v-ms:" << jms;
+    }
+    std::cout << std::endl;
+    return 0;
+}
+
+int bench_parallel_array() {
+    auto str = makeRecords(400000);
+    auto sms = timeit(3, [&str](){
+        auto tree = posdk::Json::loadFromString(str);
+    });
+    auto rms = timeit(3, [&str](){
+        posdk::Json::Reader reader(str);
+        auto records = posdk::Json::j2v<std::vector<BenchRecord>>(reader);
+    });
+    std::cout << "parallel-array bytes:" << str.size() << " cores:" << std::thread::hardware_concurrency() << " load-ms:" << sms << " j2v-ms:" << rms;
+    for(size_t threads : {size_t(1), size_t(2), size_t(4), size_t(8)}) {
+        posdk::Json::ParallelOptions popts;
+        popts.threads = threads;
+        auto tms = timeit(3, [&str, &popts](){
+            posdk::Json::Tree tree;
+            posdk::Json::loadArray(str, "bench", tree, posdk::Json::ParseOptions(), popts);
+        });
+        auto jms = timeit(3, [&str, &popts](){
+            auto records = posdk::Json::j2vArray<BenchRecord>(str, "bench", posdk::Json::ParseOptions(), popts);
+        });
+        std::cout << " threads-" << threads << "-tree-ms:" << tms << " j2v-ms:" << jms;
+    }
+    std::cout << std::endl;
+    return 0;
+}
+
+int bench_lazy() {
+    // a small header and record ahead of large payloads nobody reads
+    std::ostringstream os;
+    os << "{\"Header\": {\"Version\": 3, \"Source\": \"bench\"}, \"Record\": {\"DocumentID\": \"doc-42\", \"Items\": [";
+    for(int i = 0; i < 50000; ++i) {
+        os << (i ? "," : "") << "{\"id\": " << i << ", \"name\": \"item" << i << "\", \"price\": " << i << ".25, \"tags\": [\"a\", \"b\"]}";
+    }
+    os << "], \"Title\": \"lazy\"}, \"Attachments\": [";
+    for(int i = 0; i < 20000; ++i) {
+        os << (i ? "," : "") << "{\"file\": \"f" << i << ".bin\", \"size\": " << i * 7 << ", \"data\": \"QUJDREVGR0hJSktMTU5PUFFSU1RVVldYWVo=\"}";
+    }
+    os << "]}";
+    auto str = os.str();
+
+    std::string id;
+    auto extract = [&id](const posdk::Json::Tree& tree){
+        auto& rec = tree.getChild("Record");
+        id = rec.get<std::string>("DocumentID");
+        id += rec.get<std::string>("Title");
+        id += std::to_string(tree.getChild("Header").get<int64_t>("Version"));
+    };
+    auto ems = timeit(5, [&str, &extract](){
+        extract(posdk::Json::loadFromString(str));
+    });
+    posdk::Json::ParseOptions opts;
+    opts.lazy = true;
+    auto lms = timeit(5, [&str, &opts, &extract](){
+        extract(posdk::Json::loadFromString(str, opts));
+    });
+    std::cout << "lazy-extract-3 bytes:" << str.size() << " field:" << id << " eager-ms:" << ems << " lazy-ms:" << lms << std::endl;
+    return 0;
+}
+
+int bench_path() {
+    std::ostringstream os;
+    os << "{\"Header\": {\"Version\": 3}, \"Items\": [";
+    for(int i = 0; i < 50000; ++i) {
+        os << (i ? "," : "") << "{\"id\": " << i << ", \"name\": \"item" << i << "\", \"price\": " << i << ".25}";
+    }
+    os << "], \"Record\": {\"Meta\": {\"Owner\": {\"Name\": \"bench\"}}, \"DocumentID\": \"doc-42\"}}";
+    auto str = os.str();
+    auto tree = posdk::Json::loadFromString(str);
+
+    size_t len = 0;
+    auto cms = timeit(1000000, [&tree, &len](){
+        len += tree.getChild("Record").getChild("Meta").getChild("Owner").getChild("Name").getStringView().size();
+    });
+    auto path = posdk::Json::Path::dotted("Record.Meta.Owner.Name");
+    auto pms = timeit(1000000, [&tree, &path, &len](){
+        len += path.get(tree).getStringView().size();
+    });
+    auto lms = timeit(5, [&str, &len](){
+        auto t = posdk::Json::loadFromString(str);
+        len += t.getChild("Record").get<std::string>("DocumentID").size();
+    });
+    posdk::Json::PathSelector selector({posdk::Json::Path::pointer("/Record/DocumentID"), posdk::Json::Path::pointer("/Header/Version")});
+    auto sms = timeit(5, [&str, &selector, &len](){
+        posdk::Json::parse(str, "bench", selector);
+        len += selector.result(0)->getStringView().size();
+    });
+    std::cout << "path bytes:" << str.size() << " getchild-chain-ns:" << cms * 1e6 << " compiled-path-ns:" << pms * 1e6
+              << " load-extract-ms:" << lms << " select-extract-ms:" << sms << " (" << len << ")" << std::endl;
+    return 0;
+}
+
+int bench_cbor() {
+    auto tree = posdk::Json::loadFromString(makeRecords(20000));
+    auto json = posdk::Json::saveToString(tree, 0);
+    auto cbor = posdk::Json::saveToString(tree, posdk::Json::Encoding::Cbor);
+    posdk::Json::ParseOptions opts;
+    opts.encoding = posdk::Json::Encoding::Cbor;
+
+    auto jsms = timeit(20, [&tree](){
+        auto str = posdk::Json::saveToString(tree, 0);
+    });
+    auto csms = timeit(20, [&tree](){
+        auto str = posdk::Json::saveToString(tree, posdk::Json::Encoding::Cbor);
+    });
+    auto jlms = timeit(20, [&json](){
+        auto t = posdk::Json::loadFromString(json);
+    });
+    auto clms = timeit(20, [&cbor, &opts](){
+        auto t = posdk::Json::loadFromString(cbor, opts);
+    });
+
+    // the same jsave/jload code, writing and reading either encoding
+    auto records = posdk::Json::j2v<std::vector<BenchRecord>>(tree);
+    auto jwms = timeit(20, [&records](){
+        posdk::Json::Writer writer(posdk::Json::Encoding::Json);
+        posdk::Json::v2j(writer, records);
+    });
+    auto cwms = timeit(20, [&records](){
+        posdk::Json::Writer writer(posdk::Json::Encoding::Cbor);
+        posdk::Json::v2j(writer, records);
+    });
+    auto jrms = timeit(20, [&json](){
+        posdk::Json::Reader reader(json);
+        auto r = posdk::Json::j2v<std::vector<BenchRecord>>(reader);
+    });
+    auto crms = timeit(20, [&cbor, &opts](){
+        posdk::Json::Reader reader(cbor, "bench", opts);
+        auto r = posdk::Json::j2v<std::vector<BenchRecord>>(reader);
+    });
+    std::cout << "cbor json-bytes:" << json.size() << " cbor-bytes:" << cbor.size()
+              << " tree-save-json-ms:" << jsms << " tree-save-cbor-ms:" << csms << " tree-load-json-ms:" << jlms << " tree-load-cbor-ms:" << clms
+              << " v2j-json-ms:" << jwms << " v2j-cbor-ms:" << cwms << " j2v-json-ms:" << jrms << " j2v-cbor-ms:" << crms << std::endl;
+    return 0;
+}
+
+int bench_packed() {
+    std::vector<float> frame(1000000);
+    for(size_t i = 0; i < frame.size(); ++i) {
+        frame[i] = static_cast<float>(i % 4096) * 0.125f - 100.0f;
+    }
+
+    // a Tree node per element, as before, against one packed node
+    auto nms = timeit(5, [&frame](){
+        posdk::Json::Tree tree(posdk::Json::DataType::Array);
+        for(auto& x : frame) {
+            tree.add(posdk::Json::Tree(x));
+        }
+    });
+    auto pms = timeit(5, [&frame](){
+        auto tree = posdk::Json::Tree::packed(frame.data(), frame.size());
+    });
+    auto packed = posdk::Json::Tree::packed(frame.data(), frame.size());
+    auto nodes = posdk::Json::loadFromString(posdk::Json::saveToString(packed, 0));
+    auto njms = timeit(5, [&nodes](){
+        auto v = posdk::Json::j2v<std::vector<float>>(nodes);
+    });
+    auto pjms = timeit(5, [&packed](){
+        auto v = posdk::Json::j2v<std::vector<float>>(packed);
+    });
+
+    // Json array against the base64 packed form, through Writer and Reader
+    std::string json;
+    std::string b64;
+    auto jwms = timeit(5, [&frame, &json](){
+        posdk::Json::Writer writer(0);
+        posdk::Json::v2j(writer, frame);
+        json = writer.release();
+    });
+    auto bwms = timeit(5, [&frame, &b64](){
+        posdk::Json::Writer writer(0);
+        writer.packArrays(true);
+        posdk::Json::v2j(writer, frame);
+        b64 = writer.release();
+    });
+    auto jrms = timeit(5, [&json](){
+        posdk::Json::Reader reader(json);
+        auto v = posdk::Json::j2v<std::vector<float>>(reader);
+    });
+    auto brms = timeit(5, [&b64](){
+        posdk::Json::Reader reader(b64);
+        auto v = posdk::Json::j2v<std::vector<float>>(reader);
+    });
+    std::cout << "packed floats:" << frame.size() << " v2j-nodes-ms:" << nms << " v2j-packed-ms:" << pms << " j2v-nodes-ms:" << njms << " j2v-packed-ms:" << pjms
+              << " json-bytes:" << json.size() << " base64-bytes:" << b64.size()
+              << " write-json-ms:" << jwms << " write-base64-ms:" << bwms << " read-json-ms:" << jrms << " read-base64-ms:" << brms << std::endl;
+    return 0;
+}
+
+/// \brief BenchRecord with JASER_FIELDS instead of the hand written members
+struct BenchFields {
+    int64_t id = 0;
+    std::string name;
+    bool active = true;
+    std::vector<std::string> tags = {"a", "b"};
+    double score = 1.5;
+    JASER_FIELDS(id, name, active, tags, score)
+};
+
+int bench_fields() {
+    auto str = makeRecords(100000);
+    auto hand = posdk::Json::j2v<std::vector<BenchRecord>>(posdk::Json::loadFromString(str));
+    auto fields = posdk::Json::j2v<std::vector<BenchFields>>(posdk::Json::loadFromString(str));
+    auto tree = posdk::Json::loadFromString(str);
+
+    auto thms = timeit(5, [&tree](){
+        auto r = posdk::Json::j2v<std::vector<BenchRecord>>(tree);
+    });
+    auto tfms = timeit(5, [&tree](){
+        auto r = posdk::Json::j2v<std::vector<BenchFields>>(tree);
+    });
+    auto rhms = timeit(5, [&str](){
+        posdk::Json::Reader reader(str);
+        auto r = posdk::Json::j2v<std::vector<BenchRecord>>(reader);
+    });
+    auto rfms = timeit(5, [&str](){
+        posdk::Json::Reader reader(str);
+        auto r = posdk::Json::j2v<std::vector<BenchFields>>(reader);
+    });
+    auto vhms = timeit(5, [&hand](){
+        auto t = posdk::Json::v2j(hand);
+    });
+    auto vfms = timeit(5, [&fields](){
+        auto t = posdk::Json::v2j(fields);
+    });
+    auto whms = timeit(5, [&hand](){
+        posdk::Json::Writer writer(0);
+        posdk::Json::v2j(writer, hand);
+    });
+    auto wfms = timeit(5, [&fields](){
+        posdk::Json::Writer writer(0);
+        posdk::Json::v2j(writer, fields);
+    });
+    std::cout << "fields records:" << fields.size() << " j2v-tree-hand-ms:" << thms << " j2v-tree-fields-ms:" << tfms
+              << " j2v-reader-hand-ms:" << rhms << " j2v-reader-fields-ms:" << rfms
+              << " v2j-tree-hand-ms:" << vhms << " v2j-tree-fields-ms:" << vfms
+              << " v2j-writer-hand-ms:" << whms << " v2j-writer-fields-ms:" << wfms << std::endl;
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    bench_deep_nesting();
+    bench_numeric_array();
+    bench_arena();
+    bench_borrow();
+    bench_strings();
+    bench_structural();
+    bench_lookup();
+    bench_numbers();
+    bench_serialise();
+    bench_serialise_numbers();
+    bench_serialise_strings();
+    bench_serialiser_writer();
+    bench_deserialiser_reader();
+    bench_sax();
+    bench_push();
+    bench_lines();
+    bench_parallel_lines();
+    bench_parallel_array();
+    bench_lazy();
+    bench_path();
+    bench_cbor();
+    bench_packed();
+    bench_fields();
+    return 0;
+}
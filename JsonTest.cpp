@@ -1,5 +1,7 @@
 #include "JsonSerialiser.hpp"
 #include <assert.h>
+#include <atomic>
+#include <thread>
 
 int test_basic() {
     struct test1 {
@@ -266,6 +268,424 @@ int test_map() {
     return 0;
 }
 
+int test_writer() {
+    struct test1 {
+      int i1 = 3;
+      inline void jsave(posdk::Json::Tree& jobj) const {
+        jset(jobj, "i1", i1);
+      }
+    };
+
+    struct test2 {
+      std::string s1 = "a\"b";
+      enumx1 ex1 = enumx1::val2;
+      std::vector<int> v1 = {1, 2, 3};
+      std::map<std::string,double> m1 = {{"x", 1.5}};
+      std::variant<posdk::Json::string_t, int, std::monostate> var1 = 7;
+      test1 t1;
+
+      inline void jsave(posdk::Json::Tree& jobj) const {
+        jset(jobj, "s1", s1);
+        jset(jobj, "ex1", ex1);
+        jset(jobj, "v1", v1);
+        jset(jobj, "m1", m1);
+        jset(jobj, "var1", var1);
+        jset(jobj, "t1", t1);
+      }
+
+      inline void jsave(posdk::Json::Writer& writer) const {
+        jset(writer, "s1", s1);
+        jset(writer, "ex1", ex1);
+        jset(writer, "v1", v1);
+        jset(writer, "m1", m1);
+        jset(writer, "var1", var1);
+        jset(writer, "t1", t1);
+      }
+    };
+
+    std::vector<test2> tv(2);
+    tv[1].var1 = std::monostate();
+    auto x1 = posdk::Json::saveToString(posdk::Json::v2j(tv));
+
+    posdk::Json::Writer writer;
+    posdk::Json::v2j(writer, tv);
+    std::cout << "x:" << writer.view() << std::endl;
+    assert(writer.view() == x1);
+
+    return 0;
+}
+
+int test_reader() {
+    struct test1 {
+      int i1 = 0;
+      std::string s1;
+      enumx1 ex1 = enumx1::val1;
+      std::vector<double> v1;
+      std::map<std::string,int> m1;
+      std::variant<posdk::Json::string_t, int> var1;
+      inline test1() {}
+
+      inline bool jload(posdk::Json::Reader& reader, const std::string_view& key) {
+        if(key == "i1") return jget(reader, i1);
+        if(key == "s1") return jget(reader, s1);
+        if(key == "ex1") return jget(reader, ex1);
+        if(key == "v1") return jget(reader, v1);
+        if(key == "m1") return jget(reader, m1);
+        if(key == "var1") return jget(reader, var1);
+        return false;
+      }
+
+      inline void jsave(posdk::Json::Writer& writer) const {
+        jset(writer, "i1", i1);
+        jset(writer, "s1", s1);
+        jset(writer, "ex1", ex1);
+        jset(writer, "v1", v1);
+        jset(writer, "m1", m1);
+        jset(writer, "var1", var1);
+      }
+    };
+
+    std::vector<test1> tv(2);
+    tv[0].i1 = 5;
+    tv[0].s1 = "q\"q";
+    tv[0].ex1 = enumx1::val2;
+    tv[0].v1 = {1.5, 2};
+    tv[0].m1["k"] = 3;
+    tv[0].var1 = "str";
+    tv[1].var1 = 9;
+
+    posdk::Json::Writer writer;
+    posdk::Json::v2j(writer, tv);
+    auto str = std::string(writer.view());
+
+    // unknown keys are skipped, __data__ may come before __varidx__
+    str.insert(str.find("\"i1\""), "\"extra\":{\"a\":[1,{}]},");
+    auto pos = str.rfind("\"__varidx__\":1,");
+    str.replace(pos, 15, "\"__data__\":9,");
+    str.replace(str.find("\"__data__\":9", pos + 13), 12, "\"__varidx__\":1");
+
+    posdk::Json::Reader reader(str);
+    auto tv2 = posdk::Json::j2v<std::vector<test1>>(reader);
+    assert(tv2.size() == 2);
+    assert(tv2[0].i1 == 5);
+    assert(tv2[0].s1 == "q\"q");
+    assert(tv2[0].ex1 == enumx1::val2);
+    assert(tv2[0].v1.size() == 2);
+    assert(tv2[0].v1[1] == 2.0);
+    assert(tv2[0].m1["k"] == 3);
+    assert(std::get<posdk::Json::string_t>(tv2[0].var1) == "str");
+    assert(std::get<int>(tv2[1].var1) == 9);
+    assert(reader.next() == posdk::Json::Token::End);
+
+    writer.clear();
+    posdk::Json::v2j(writer, tv2);
+    std::cout << "x:" << writer.view() << std::endl;
+    return 0;
+}
+
+int test_lines() {
+    struct rec {
+      int id = 0;
+      std::string name;
+      inline rec() {}
+
+      inline bool jload(posdk::Json::Reader& reader, const std::string_view& key) {
+        if(key == "id") return jget(reader, id);
+        if(key == "name") return jget(reader, name);
+        return false;
+      }
+
+      inline void jsave(posdk::Json::Writer& writer) const {
+        jset(writer, "id", id);
+        jset(writer, "name", name);
+      }
+    };
+
+    std::ostringstream os;
+    posdk::Json::OstreamSink sink(os);
+    posdk::Json::Writer writer(sink, 0, 16);
+    for(int i = 0; i < 50; ++i) {
+        rec r;
+        r.id = i;
+        r.name = "n\n" + std::to_string(i);
+        posdk::Json::jline(writer, r);
+    }
+    writer.flush();
+    auto str = os.str() + "\r\n\n";
+
+    // a tiny block size makes every line cross a block boundary
+    std::istringstream is(str);
+    posdk::Json::LineReader lines(is, "<lines>", posdk::Json::ParseOptions(), 8);
+    rec r;
+    int count = 0;
+    while(posdk::Json::jnext(lines, r)) {
+        assert(r.id == count);
+        assert(r.name == "n\n" + std::to_string(count));
+        ++count;
+    }
+    assert(count == 50);
+
+    // whitespace may follow the value, anything else on the line is an error
+    posdk::Json::LineReader spaced("{\"id\":1,\"name\":\"a\"} \t\n");
+    assert(posdk::Json::jnext(spaced, r) && (r.id == 1));
+#ifdef NDEBUG
+    posdk::Json::LineReader joined("{\"id\":1,\"name\":\"a\"} {\"id\":2,\"name\":\"b\"}\n");
+    bool thrown = false;
+    try {
+        posdk::Json::jnext(joined, r);
+    }catch(const posdk::JsonError&) {
+        thrown = true;
+    }
+    assert(thrown);
+#endif
+
+    posdk::Json::LineReader trees(str);
+    posdk::Json::Tree tree;
+    count = 0;
+    while(trees.next(tree)) {
+        assert(tree.getChild("id").getValue<int>() == count);
+        ++count;
+    }
+    assert(count == 50);
+
+    // small chunks, so that every thread gets several
+    posdk::Json::ParallelOptions popts;
+    popts.threads = 3;
+    popts.chunkSize = 64;
+    std::vector<int> ids;
+    posdk::Json::j2vLines<rec>(str, "<lines>", [&ids](rec& r){ ids.push_back(r.id); }, posdk::Json::ParseOptions(), popts);
+    assert(ids.size() == 50);
+    for(int i = 0; i < 50; ++i) {
+        assert(ids[i] == i);
+    }
+    popts.ordered = false;
+    std::atomic<int> sum(0);
+    posdk::Json::parseLines(str, "<lines>", [&sum](posdk::Json::Tree& t){ sum += t.getChild("id").getValue<int>(); }, posdk::Json::ParseOptions(), popts);
+    assert(sum == (49 * 50) / 2);
+
+    // an element that does not convert throws from the chunks, only text that is not json
+    // is read again serially. one thread converts the chunks in order and stops at the error
+    static std::atomic<int> loads(0);
+    struct counted {
+      int id = 0;
+      inline bool jload(posdk::Json::Reader& reader, const std::string_view& key) {
+        if(key == "id") {
+          ++loads;
+          return jget(reader, id);
+        }
+        return false;
+      }
+    };
+    std::string array = "[";
+    for(int i = 0; i < 50; ++i) {
+        array += ((i == 0) ? "" : ",") + std::string("{\"id\":") + ((i == 25) ? "\"x\"" : std::to_string(i)) + "}";
+    }
+    array += "]";
+    popts.threads = 1;
+    bool converted = false;
+    try {
+        posdk::Json::j2vArray<counted>(array, "<array>", posdk::Json::ParseOptions(), popts);
+        converted = true;
+    }catch(const posdk::JsonError&) {
+    }
+    assert(!converted && (loads == 26));
+    array.replace(array.find("\"x\""), 3, "25 ");
+    auto counts = posdk::Json::j2vArray<counted>(array, "<array>", posdk::Json::ParseOptions(), popts);
+    assert((counts.size() == 50) && (counts[25].id == 25));
+#ifdef NDEBUG
+    loads = 0;
+    array.replace(array.find("25 "), 3, "25x");
+    try {
+        posdk::Json::j2vArray<counted>(array, "<array>", posdk::Json::ParseOptions(), popts);
+        converted = true;
+    }catch(const posdk::JsonError&) {
+    }
+    assert(!converted && (loads == 52));
+#endif
+    std::cout << "lines:" << str.substr(0, str.find('\n')) << std::endl;
+    return 0;
+}
+
+int test_cbor() {
+    struct test1 {
+      int i1 = 0;
+      std::string s1;
+      std::vector<double> v1;
+      std::map<std::string,int> m1;
+      std::variant<posdk::Json::string_t, int> var1;
+      inline test1() {}
+
+      inline bool jload(posdk::Json::Reader& reader, const std::string_view& key) {
+        if(key == "i1") return jget(reader, i1);
+        if(key == "s1") return jget(reader, s1);
+        if(key == "v1") return jget(reader, v1);
+        if(key == "m1") return jget(reader, m1);
+        if(key == "var1") return jget(reader, var1);
+        return false;
+      }
+
+      inline void jsave(posdk::Json::Writer& writer) const {
+        jset(writer, "i1", i1);
+        jset(writer, "s1", s1);
+        jset(writer, "v1", v1);
+        jset(writer, "m1", m1);
+        jset(writer, "var1", var1);
+      }
+    };
+
+    std::vector<test1> tv(2);
+    tv[0].i1 = -70000;
+    tv[0].s1 = "q\"q";
+    tv[0].v1 = {1.5, 0.1};
+    tv[0].m1["k"] = 3;
+    tv[0].var1 = "str";
+    tv[1].var1 = 9;
+
+    // the same jsave and jload, in CBOR
+    posdk::Json::Writer writer(posdk::Json::Encoding::Cbor);
+    posdk::Json::v2j(writer, tv);
+    auto cbor = std::string(writer.view());
+
+    posdk::Json::ParseOptions opts;
+    opts.encoding = posdk::Json::Encoding::Cbor;
+    posdk::Json::Reader reader(cbor, "test_cbor", opts);
+    auto tv2 = posdk::Json::j2v<std::vector<test1>>(reader);
+    assert(reader.next() == posdk::Json::Token::End);
+    assert(tv2.size() == 2);
+    assert(tv2[0].i1 == -70000);
+    assert(tv2[0].s1 == "q\"q");
+    assert(tv2[0].v1[1] == 0.1);
+    assert(tv2[0].m1["k"] == 3);
+    assert(std::get<posdk::Json::string_t>(tv2[0].var1) == "str");
+    assert(std::get<int>(tv2[1].var1) == 9);
+
+    // and through a Tree
+    auto tree = posdk::Json::loadFromString(cbor, opts);
+    auto json = posdk::Json::saveToString(tree, 0);
+    posdk::Json::Writer text(0);
+    posdk::Json::v2j(text, tv);
+    assert(json == text.view());
+    assert(posdk::Json::saveToString(tree, posdk::Json::Encoding::Cbor) == cbor);
+    std::cout << "cbor:" << cbor.size() << " json:" << json.size() << " " << json << std::endl;
+    return 0;
+}
+
+int test_packed() {
+    std::vector<float> v1 = {1.5f, -0.25f, 12.3f};
+    std::vector<int16_t> v2 = {-300, 0, 7};
+
+    // a packed Tree array is written like any array and copied straight back
+    assert(!posdk::Json::v2j(v1).isPacked());
+    auto tree = posdk::Json::Tree::packed(v1.data(), v1.size());
+    assert(tree.isPacked());
+    assert(posdk::Json::saveToString(tree, 0) == "[1.5,-0.25,12.3]");
+    auto v3 = posdk::Json::j2v<std::vector<float>>(tree);
+    assert(v3 == v1);
+    auto v4 = posdk::Json::j2v<std::vector<double>>(tree);
+    assert(v4[2] == 12.300000190734863);
+
+    // its children are created when accessed
+    assert(tree.size() == 3);
+    assert(!tree.isPacked());
+    assert(tree.at(1).getValue<double>() == -0.25);
+
+    // also through a const Tree, from several threads at once
+    const auto shared = posdk::Json::Tree::packed(v1.data(), v1.size());
+    assert(shared.isPacked());
+    std::vector<std::thread> readers;
+    std::atomic<int> found(0);
+    for(int i = 0; i < 4; ++i) {
+        readers.emplace_back([&shared, &found]() {
+            if((shared.size() == 3) && (shared.at(2).getValue<float>() == 12.3f)) {
+                ++found;
+            }
+        });
+    }
+    for(auto& t : readers) {
+        t.join();
+    }
+    assert(found == 4);
+    assert(!shared.isPacked());
+    assert(posdk::Json::saveToString(shared, 0) == "[1.5,-0.25,12.3]");
+    assert(posdk::Json::j2v<std::vector<float>>(shared) == v1);
+
+    // base64 form, read back through a Tree and a Reader
+    posdk::Json::Writer writer(0);
+    writer.packArrays(true);
+    posdk::Json::v2j(writer, v2);
+    auto json = std::string(writer.view());
+    assert(json == "{\"__packed__\":\"i16\",\"__data__\":\"1P4AAAcA\"}");
+    auto v5 = posdk::Json::j2v<std::vector<int16_t>>(posdk::Json::loadFromString(json));
+    assert(v5 == v2);
+    posdk::Json::Reader reader(json);
+    auto v6 = posdk::Json::j2v<std::vector<int>>(reader);
+    assert(v6[0] == -300);
+
+    // the plain array form still reads into any number type
+    posdk::Json::Reader reader2("[1, 2.5]");
+    auto v7 = posdk::Json::j2v<std::vector<double>>(reader2);
+    assert(v7[1] == 2.5);
+    std::cout << "packed:" << json << std::endl;
+    return 0;
+}
+
+int test_fields() {
+    struct point {
+      int x = 0;
+      int y = 0;
+      JASER_FIELDS(x, y)
+    };
+    struct test1 {
+      int i1 = 3;
+      std::string s1 = "abc";
+      std::vector<point> v1;
+      std::map<std::string, int> m1;
+      double d1 = 45.6;
+      JASER_FIELDS(i1, s1,
+                   v1, m1, d1)
+    };
+
+    test1 t1;
+    t1.v1 = {{1, 2}, {3, 4}};
+    t1.m1["k"] = 5;
+    auto x = posdk::Json::saveToString(posdk::Json::v2j(t1), 0);
+    assert(x == "{\"i1\":3,\"s1\":\"abc\",\"v1\":[{\"x\":1,\"y\":2},{\"x\":3,\"y\":4}],\"m1\":[{\"__key__\":\"k\",\"__val__\":5}],\"d1\":45.6}");
+
+    // the Writer produces the same text, and both directions read it back
+    posdk::Json::Writer writer(0);
+    posdk::Json::v2j(writer, t1);
+    assert(writer.view() == x);
+    auto t2 = posdk::Json::j2v<test1>(posdk::Json::loadFromString(x));
+    assert((t2.v1[1].y == 4) && (t2.m1["k"] == 5) && (t2.d1 == 45.6));
+    posdk::Json::Reader reader(x);
+    auto t3 = posdk::Json::j2v<test1>(reader);
+    assert((t3.v1[0].x == 1) && (t3.s1 == "abc"));
+
+    // keys in any order, unknown keys skipped, missing ones keep their default
+    std::string y = "{\"d1\":1.5,\"zz\":[1],\"i1\":7}";
+    auto t4 = posdk::Json::j2v<test1>(posdk::Json::loadFromString(y));
+    posdk::Json::Reader reader2(y);
+    auto t5 = posdk::Json::j2v<test1>(reader2);
+    assert((t4.i1 == 7) && (t4.d1 == 1.5) && (t4.s1 == "abc"));
+    assert((t5.i1 == 7) && (t5.d1 == 1.5) && (t5.s1 == "abc"));
+
+    // floats are written alike through a Tree, the Writer and a packed array
+    struct floats {
+      float f = 12.3f;
+      std::vector<float> v = {0.1f, 12.3f};
+      JASER_FIELDS(f, v)
+    };
+    floats f1;
+    auto fx = posdk::Json::saveToString(posdk::Json::v2j(f1), 0);
+    assert(fx == "{\"f\":12.3,\"v\":[0.1,12.3]}");
+    posdk::Json::Writer fwriter(0);
+    posdk::Json::v2j(fwriter, f1);
+    assert(fwriter.view() == fx);
+    assert(posdk::Json::saveToString(posdk::Json::Tree::packed(f1.v.data(), f1.v.size()), 0) == "[0.1,12.3]");
+    std::cout << "fields:" << x << std::endl;
+    return 0;
+}
+
 int main(int argc, char* argv[]) {
     test_basic();
     test_inherit();
@@ -273,5 +693,11 @@ int main(int argc, char* argv[]) {
     test_variant();
     test_vector();
     test_map();
+    test_writer();
+    test_reader();
+    test_lines();
+    test_cbor();
+    test_packed();
+    test_fields();
     return 0;
 }
@@ -1 +1,2 @@
-clang++ -g --std=c++17 -Wall JsonTest.cpp Json.cpp -o jtest
+clang++ -g --std=c++17 -Wall JsonTest.cpp Json.cpp -o jtest -pthread
+clang++ -O2 --std=c++17 -Wall JsonBench.cpp Json.cpp -o jbench -pthread
@@ -2,11 +2,21 @@
 
 #include <iostream>
 #include <sstream>
-#include <list>
+#include <optional>
+#include <iterator>
+#include <functional>
 #include <vector>
 #include <cstddef>
 #include <map>
+#include <atomic>
+#include <memory>
+#include <memory_resource>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <type_traits>
 #include <variant>
+#include <string_view>
 
 namespace posdk {
     class JsonError : public std::runtime_error {
@@ -20,65 +30,602 @@ namespace posdk {
         typedef std::nullptr_t null_t;
         typedef bool bool_t;
         typedef int64_t integer_t;
-        typedef float float_t;
+        /// \brief only holds values above INT64_MAX, everything else is an integer_t
+        typedef uint64_t uinteger_t;
+        typedef double float_t;
         typedef std::string string_t;
 
+        /// \brief string stored outside the node, in an arena or a retained input buffer
+        typedef std::string_view strview_t;
+
         typedef std::variant<
             null_t,
             bool_t,
             integer_t,
+            uinteger_t,
             float_t,
-            string_t
+            string_t,
+            strview_t
         > Value_t;
 
-        enum class DataType {
+        /// \brief object key, its bytes are allocated from the owning tree's resource
+        /// or, when borrowed, live in an input buffer that outlives the tree.
+        /// hash and size sit next to each other so a lookup compares both in one go
+        struct Key {
+            uint32_t hash;
+            uint32_t size : 31;
+            uint32_t borrowed : 1;
+            const char* data;
+
+            inline std::string_view view() const {
+                return std::string_view(data, size);
+            }
+
+            inline uint64_t tag() const {
+                return (static_cast<uint64_t>(size) << 32) | hash;
+            }
+        };
+
+        class Writer;
+
+        /// \brief element type of a packed numeric array, see Tree::packed()
+        enum class Packed : uint8_t {
+            Int8,
+            UInt8,
+            Int16,
+            UInt16,
+            Int32,
+            UInt32,
+            Int64,
+            UInt64,
+            Float32,
+            Float64,
+        };
+
+        /// \brief integers other than bool, float and double can be packed
+        template <typename ValT>
+        struct isPackable : std::integral_constant<bool,
+            (std::is_integral<ValT>::value && !std::is_same<ValT, bool_t>::value && (sizeof(ValT) <= 8)) ||
+            std::is_same<ValT, float>::value || std::is_same<ValT, double>::value> {};
+
+        template <typename ValT>
+        constexpr Packed packedTypeOf() {
+            static_assert(isPackable<ValT>::value, "element type cannot be packed");
+            if constexpr (std::is_floating_point<ValT>::value) {
+                return (sizeof(ValT) == 4) ? Packed::Float32 : Packed::Float64;
+            } else {
+                constexpr uint8_t base = (sizeof(ValT) == 1) ? 0 : (sizeof(ValT) == 2) ? 2 : (sizeof(ValT) == 4) ? 4 : 6;
+                return static_cast<Packed>(base + (std::is_signed<ValT>::value ? 0 : 1));
+            }
+        }
+
+        /// \brief bytes per element
+        inline size_t packedWidth(const Packed& type) {
+            static const uint8_t widths[] = {1, 1, 2, 2, 4, 4, 8, 8, 4, 8};
+            return widths[static_cast<size_t>(type)];
+        }
+
+        /// \brief name of the element type in the base64 form, see Writer::packArrays()
+        inline std::string_view packedName(const Packed& type) {
+            static const char* names[] = {"i8", "u8", "i16", "u16", "i32", "u32", "i64", "u64", "f32", "f64"};
+            return names[static_cast<size_t>(type)];
+        }
+
+        inline bool packedFromName(const std::string_view& name, Packed& type) {
+            for(uint8_t i = 0; i <= static_cast<uint8_t>(Packed::Float64); ++i){
+                if(packedName(static_cast<Packed>(i)) == name){
+                    type = static_cast<Packed>(i);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /// \brief calls fn with a zero of the C++ type that holds elements of type
+        template <typename FnT>
+        inline void visitPacked(const Packed& type, FnT&& fn) {
+            switch(type){
+            case Packed::Int8: fn(int8_t(0)); break;
+            case Packed::UInt8: fn(uint8_t(0)); break;
+            case Packed::Int16: fn(int16_t(0)); break;
+            case Packed::UInt16: fn(uint16_t(0)); break;
+            case Packed::Int32: fn(int32_t(0)); break;
+            case Packed::UInt32: fn(uint32_t(0)); break;
+            case Packed::Int64: fn(int64_t(0)); break;
+            case Packed::UInt64: fn(uint64_t(0)); break;
+            case Packed::Float32: fn(float(0)); break;
+            case Packed::Float64: fn(double(0)); break;
+            }
+        }
+
+        /// \brief val as ValT, with the same checks as Tree::getValue()
+        template <typename ValT, typename SrcT>
+        inline ValT convertPacked(const SrcT& val) {
+            if constexpr (std::is_floating_point<ValT>::value) {
+                return static_cast<ValT>(val);
+            } else if constexpr (std::is_floating_point<SrcT>::value) {
+                throw posdk::JsonError("unexpected value type in JSON node");
+            } else {
+                if constexpr (std::is_signed<SrcT>::value) {
+                    if(val < 0){
+                        if(!std::is_signed<ValT>::value || (static_cast<integer_t>(val) < static_cast<integer_t>(std::numeric_limits<ValT>::min()))){
+                            throw posdk::JsonError("integer out of range in JSON node");
+                        }
+                        return static_cast<ValT>(val);
+                    }
+                }
+                if(static_cast<uinteger_t>(val) > static_cast<uinteger_t>(std::numeric_limits<ValT>::max())){
+                    throw posdk::JsonError("integer out of range in JSON node");
+                }
+                return static_cast<ValT>(val);
+            }
+        }
+
+        /// \brief append count elements of type, stored at data in host byte order, to out.
+        /// the same type is copied in one go, any other is converted element by element
+        template <typename ValT>
+        inline void unpackElements(const Packed& type, const char* data, const size_t& count, std::vector<ValT>& out) {
+            auto base = out.size();
+            if(type == packedTypeOf<ValT>()){
+                out.resize(base + count);
+                if(count > 0){
+                    std::memcpy(out.data() + base, data, count * sizeof(ValT));
+                }
+                return;
+            }
+            out.reserve(base + count);
+            visitPacked(type, [&](auto zero){
+                typedef decltype(zero) SrcT;
+                for(size_t i = 0; i < count; ++i){
+                    SrcT val;
+                    std::memcpy(&val, data + (i * sizeof(SrcT)), sizeof(SrcT));
+                    out.push_back(convertPacked<ValT>(val));
+                }
+            });
+        }
+
+        /// \brief RFC 4648 base64 with padding
+        std::string encodeBase64(const char* data, const size_t& size);
+        /// \brief throws on characters outside the base64 alphabet or a bad length
+        std::string decodeBase64(const std::string_view& str);
+
+        /// \brief append the elements of the base64 packed form {"__packed__":name,"__data__":data}
+        template <typename ValT>
+        inline void unpackBase64(const std::string_view& name, const std::string_view& data, std::vector<ValT>& out) {
+            Packed type;
+            if(!packedFromName(name, type)){
+                throw posdk::JsonError("unknown packed element type:", std::string(name));
+            }
+            auto bytes = decodeBase64(data);
+            if((bytes.size() % packedWidth(type)) != 0){
+                throw posdk::JsonError("packed data is not a whole number of elements:", std::string(name));
+            }
+            unpackElements(type, bytes.data(), bytes.size() / packedWidth(type), out);
+        }
+
+        enum class DataType : uint8_t {
             Value,
             Array,
             Object,
         };
 
+        /// \brief a Json value, array or object
+        /// containers keep their children in one contiguous vector. objects
+        /// keep their keys in a parallel vector, arrays have no key slot.
+        /// all storage of a node and its descendants comes from one memory resource.
+        /// on the default (new/delete) resource string values are owned std::strings, on any
+        /// other resource (an Arena) their bytes are allocated from it and held as views.
+        /// key lookup takes std::string_view, so no temporary std::string is built.
         class Tree {
+            /// \brief children that are created on first access, see expand()
+            enum class Pending : uint8_t {
+                None,
+                Deferred,
+                Packed,
+            };
+
             DataType dataType_;
+            /// \brief the float_t value was a float, and is written in its shortest float form
+            bool single_;
+            /// \brief set to None, with release order, once the children below are complete
+            mutable std::atomic<Pending> pending_;
+            // expand() fills these in through const accessors
+            mutable uint32_t slotCount_;
             Value_t value;
-            std::list<std::pair<std::string, Tree>> items_;
-            std::map<std::string, Tree*> names;
+            mutable std::pmr::vector<Tree> children_;
+            mutable std::pmr::vector<Key> keys_;
+            mutable uint32_t* slots_;
 
-        public:
-            typedef std::list<std::pair<std::string, Tree>>::const_iterator iterator;
-            inline Tree(const DataType& dataType = DataType::Value) : dataType_(dataType), value(nullptr) {}
-
-            explicit inline Tree(const bool_t& val) : dataType_(DataType::Value), value(val) {}
-            explicit inline Tree(const integer_t& val) : dataType_(DataType::Value), value(val) {}
-            explicit inline Tree(const float_t& val) : dataType_(DataType::Value), value(val) {}
-            explicit inline Tree(const string_t& val) : dataType_(DataType::Value), value(val) {}
-
-            // explicit inline Tree(const int& val) : dataType_(DataType::Value), value(static_cast<int64_t>(val)) {}
-            // explicit inline Tree(const uint64_t& val) : dataType_(DataType::Value), value(static_cast<int64_t>(val)) {}
-            // explicit inline Tree(const size_t& val) : dataType_(DataType::Value), value(static_cast<int64_t>(val)) {}
-
-            inline Tree(const Tree& src) : dataType_(src.dataType_), value(src.value),  items_(src.items_) {
-                if(!src.isArray()){
-                    for(auto& p : items_){
-                        names[p.first] = &p.second;
+            /// \brief objects with more keys than this get a hash index, smaller ones are scanned
+            static constexpr size_t IndexThreshold = 16;
+
+            static inline bool isArena(std::pmr::memory_resource* mr) {
+                return (mr != std::pmr::new_delete_resource());
+            }
+
+            static inline std::string_view copyTo(const std::string_view& str, std::pmr::memory_resource* mr) {
+                if(str.size() == 0){
+                    return std::string_view();
+                }
+                auto p = static_cast<char*>(mr->allocate(str.size(), 1));
+                std::copy(str.begin(), str.end(), p);
+                return std::string_view(p, str.size());
+            }
+
+            static inline Key makeKey(const std::string_view& key, std::pmr::memory_resource* mr) {
+                auto k = copyTo(key, mr);
+                return Key{hashKey(key), static_cast<uint32_t>(key.size()), 0, k.data()};
+            }
+
+            inline void freeKey(const Key& key) const {
+                if((key.size > 0) && !key.borrowed){
+                    resource()->deallocate(const_cast<char*>(key.data), key.size, 1);
+                }
+            }
+
+            inline void clearKeys() const {
+                for(auto& k : keys_){
+                    freeKey(k);
+                }
+                keys_.clear();
+            }
+
+            static inline Value_t makeValue(const Value_t& val, std::pmr::memory_resource* mr) {
+                if(std::holds_alternative<string_t>(val)){
+                    return makeString(std::get<string_t>(val), mr);
+                }
+                if(std::holds_alternative<strview_t>(val)){
+                    return makeString(std::get<strview_t>(val), mr);
+                }
+                return val;
+            }
+
+            /// \brief keeps uinteger_t for values that do not fit integer_t only
+            static inline Value_t unsignedValue(const uinteger_t& val) {
+                if(val > static_cast<uinteger_t>(std::numeric_limits<integer_t>::max())){
+                    return Value_t(val);
+                }
+                return Value_t(static_cast<integer_t>(val));
+            }
+
+            static inline uint32_t hashKey(const std::string_view& key) {
+                // FNV-1a
+                uint32_t h = 2166136261u;
+                for(auto ch : key){
+                    h ^= static_cast<unsigned char>(ch);
+                    h *= 16777619u;
+                }
+                return h;
+            }
+
+            inline void freeIndex() const {
+                if(slots_ != nullptr){
+                    resource()->deallocate(slots_, slotCount_ * sizeof(uint32_t), alignof(uint32_t));
+                    slots_ = nullptr;
+                    slotCount_ = 0;
+                }
+            }
+
+            /// \brief insert keys_[idx] into the open-addressing index, the last duplicate wins
+            inline void indexInsert(const size_t& idx) const {
+                auto& key = keys_[idx];
+                auto mask = slotCount_ - 1;
+                for(auto s = key.hash & mask;; s = (s + 1) & mask){
+                    if((slots_[s] == 0) || ((keys_[slots_[s] - 1].tag() == key.tag()) && (keys_[slots_[s] - 1].view() == key.view()))){
+                        slots_[s] = static_cast<uint32_t>(idx + 1);
+                        return;
                     }
                 }
             }
 
-            inline Tree& operator=(const Tree& src) {
-                dataType_ = src.dataType_;
-                value = src.value;
-                items_ = src.items_;
-                if(!src.isArray()){
-                    for(auto& p : items_){
-                        names[p.first] = &p.second;
+            /// \brief true if the node holds anything allocated from its resource
+            inline bool usesStorage() const {
+                return ((children_.size() > 0) || (keys_.size() > 0) || std::holds_alternative<string_t>(value) || std::holds_alternative<strview_t>(value));
+            }
+
+            inline void reindex() const {
+                freeIndex();
+                if(keys_.size() <= IndexThreshold){
+                    return;
+                }
+                uint32_t count = 64;
+                while(count < keys_.size() * 2){
+                    count *= 2;
+                }
+                slots_ = static_cast<uint32_t*>(resource()->allocate(count * sizeof(uint32_t), alignof(uint32_t)));
+                slotCount_ = count;
+                std::fill(slots_, slots_ + count, 0);
+                for(size_t i = 0; i < keys_.size(); ++i){
+                    indexInsert(i);
+                }
+            }
+
+            /// \brief position of key among the children, or size() when absent
+            /// small objects scan the packed hash/size tags from the back, so the last
+            /// duplicate wins. larger ones probe the open-addressing index.
+            inline size_t indexOf(const std::string_view& key) const {
+                expand();
+                auto hash = hashKey(key);
+                auto tag = (static_cast<uint64_t>(key.size()) << 32) | hash;
+                if(slots_ != nullptr){
+                    auto mask = slotCount_ - 1;
+                    for(auto s = hash & mask; slots_[s] != 0; s = (s + 1) & mask){
+                        auto& k = keys_[slots_[s] - 1];
+                        if((k.tag() == tag) && (k.view() == key)){
+                            return slots_[s] - 1;
+                        }
                     }
+                    return children_.size();
+                }
+                for(size_t i = keys_.size(); i > 0; --i){
+                    auto& k = keys_[i - 1];
+                    if((k.tag() == tag) && (k.view() == key)){
+                        return i - 1;
+                    }
+                }
+                return children_.size();
+            }
+
+        public:
+            /// \brief element seen while iterating a container, first is empty for arrays
+            struct Item {
+                std::string_view first;
+                const Tree& second;
+                inline Item(const std::string_view& k, const Tree& v) : first(k), second(v) {}
+            };
+
+            /// \brief iterates the children of a container as key/value Items
+            class iterator {
+                const Tree* tree_;
+                size_t idx_;
+                mutable std::optional<Item> item_;
+
+            public:
+                typedef std::forward_iterator_tag iterator_category;
+                typedef Item value_type;
+                typedef std::ptrdiff_t difference_type;
+                typedef const Item* pointer;
+                typedef const Item& reference;
+
+                inline iterator(const Tree* tree, const size_t& idx) : tree_(tree), idx_(idx) {}
+                inline iterator(const iterator& src) : tree_(src.tree_), idx_(src.idx_) {}
+                inline iterator& operator=(const iterator& src) {
+                    tree_ = src.tree_;
+                    idx_ = src.idx_;
+                    item_.reset();
+                    return *this;
+                }
+
+                inline const Item& operator*() const {
+                    item_.emplace(tree_->keyAt(idx_), tree_->children_[idx_]);
+                    return *item_;
+                }
+
+                inline const Item* operator->() const {
+                    return &(operator*());
+                }
+
+                inline iterator& operator++() {
+                    ++idx_;
+                    return *this;
+                }
+
+                inline iterator operator++(int) {
+                    iterator it(*this);
+                    ++idx_;
+                    return it;
+                }
+
+                inline bool operator==(const iterator& rhs) const {
+                    return ((tree_ == rhs.tree_) && (idx_ == rhs.idx_));
+                }
+
+                inline bool operator!=(const iterator& rhs) const {
+                    return !(*this == rhs);
+                }
+            };
+
+            inline Tree(const DataType& dataType = DataType::Value) : Tree(dataType, std::pmr::new_delete_resource()) {}
+
+            /// \brief empty node whose storage comes from mr
+            inline Tree(const DataType& dataType, std::pmr::memory_resource* mr) : dataType_(dataType), single_(false), pending_(Pending::None), slotCount_(0), value(nullptr), children_(mr), keys_(mr), slots_(nullptr) {}
+
+            explicit inline Tree(const bool_t& val) : Tree(DataType::Value) {value = val;}
+            explicit inline Tree(const integer_t& val) : Tree(DataType::Value) {value = val;}
+            explicit inline Tree(const float_t& val) : Tree(DataType::Value) {value = val;}
+            /// \brief holds the exact value as a float_t, written as text like the float
+            explicit inline Tree(const float& val) : Tree(DataType::Value) {value = static_cast<float_t>(val); single_ = true;}
+            explicit inline Tree(const string_t& val) : Tree(DataType::Value) {value = val;}
+
+            explicit inline Tree(const uinteger_t& val) : Tree(DataType::Value) {value = unsignedValue(val);}
+
+            /// \brief any other integer type: int, long long, unsigned, char...
+            template <typename IntT, typename std::enable_if<std::is_integral<IntT>::value && !std::is_same<IntT, bool_t>::value, int>::type = 0>
+            explicit inline Tree(const IntT& val) : Tree(DataType::Value) {
+                if(std::is_signed<IntT>::value){
+                    value = static_cast<integer_t>(val);
+                }else{
+                    value = unsignedValue(static_cast<uinteger_t>(val));
+                }
+            }
+
+            /// \brief string node whose bytes come from mr
+            inline Tree(const std::string_view& val, std::pmr::memory_resource* mr) : Tree(DataType::Value, mr) {
+                value = makeString(val, mr);
+            }
+
+            /// \brief deep copy of src with all storage taken from mr
+            inline Tree(const Tree& src, std::pmr::memory_resource* mr) : Tree(src.dataType_, mr) {
+                // a packed array stays packed unless its buffer would have to live in an arena
+                auto packed = (src.isPacked() && !isArena(mr));
+                if(!packed) {
+                    src.expand();
+                }
+                // an expanded container may still hold the text or buffer it came from
+                if((dataType_ == DataType::Value) || packed) {
+                    value = makeValue(src.value, mr);
+                }
+                if(packed) {
+                    pending_.store(Pending::Packed, std::memory_order_relaxed);
+                }
+                single_ = src.single_;
+                children_.reserve(src.children_.size());
+                for(auto& c : src.children_){
+                    children_.emplace_back(c, mr);
+                }
+                keys_.reserve(src.keys_.size());
+                for(auto& k : src.keys_){
+                    keys_.push_back(makeKey(k.view(), mr));
+                }
+                if(src.slots_ != nullptr){
+                    reindex();
+                }
+            }
+
+            /// \brief copies always own their storage, even when src lives in an arena
+            inline Tree(const Tree& src) : Tree(src, std::pmr::new_delete_resource()) {}
+
+            inline Tree(Tree&& src) noexcept : dataType_(src.dataType_), single_(src.single_), pending_(src.pending_.load(std::memory_order_acquire)), slotCount_(src.slotCount_), value(std::move(src.value)), children_(std::move(src.children_)), keys_(std::move(src.keys_)), slots_(src.slots_) {
+                src.pending_.store(Pending::None, std::memory_order_relaxed);
+                src.slots_ = nullptr;
+                src.slotCount_ = 0;
+            }
+
+            inline ~Tree() {
+                clearKeys();
+                freeIndex();
+                if(!children_.empty()) {
+                    destroyChildren();
+                }
+            }
+
+            /// \brief assignment keeps this node's memory resource
+            inline Tree& operator=(const Tree& src) {
+                if(this != &src) {
+                    *this = Tree(src, resource());
                 }
                 return *this;
             }
 
+            inline Tree& operator=(Tree&& src) {
+                if(this == &src) {
+                    return *this;
+                }
+                if((src.resource() != resource()) && src.usesStorage()){
+                    return operator=(static_cast<const Tree&>(src));
+                }
+                clearKeys();
+                freeIndex();
+                dataType_ = src.dataType_;
+                single_ = src.single_;
+                pending_.store(src.pending_.load(std::memory_order_acquire), std::memory_order_relaxed);
+                src.pending_.store(Pending::None, std::memory_order_relaxed);
+                value = std::move(src.value);
+                children_ = std::move(src.children_);
+                keys_ = std::move(src.keys_);
+                slots_ = src.slots_;
+                slotCount_ = src.slotCount_;
+                src.slots_ = nullptr;
+                src.slotCount_ = 0;
+                return *this;
+            }
+
+            /// \brief string value with its bytes in mr when that is an arena
+            static inline Value_t makeString(const std::string_view& str, std::pmr::memory_resource* mr) {
+                if(isArena(mr)){
+                    return Value_t(std::in_place_type<strview_t>, copyTo(str, mr));
+                }
+                return Value_t(std::in_place_type<string_t>, str);
+            }
+
+            /// \brief string node referring to bytes it does not own, which must outlive it
+            static inline Tree borrow(const std::string_view& val, std::pmr::memory_resource* mr = std::pmr::new_delete_resource()) {
+                Tree tree(DataType::Value, mr);
+                tree.value = Value_t(std::in_place_type<strview_t>, val);
+                return tree;
+            }
+
+            /// \brief container over the Json text raw, an object or an array including its
+            /// brackets, whose children are parsed when they are first accessed.
+            /// raw must outlive the tree, see ParseOptions::lazy. when input is the start of the
+            /// buffer raw was taken from, errors report name and the position in that buffer
+            static inline Tree deferred(const std::string_view& raw, std::pmr::memory_resource* mr = std::pmr::new_delete_resource(), const std::string_view& name = "<lazy>", const char* input = nullptr) {
+                Tree tree(((raw.size() > 0) && (raw[0] == '{')) ? DataType::Object : DataType::Array, mr);
+                tree.value = Value_t(std::in_place_type<strview_t>, raw);
+                tree.setSource(name, (input != nullptr) ? input : raw.data());
+                tree.pending_.store(Pending::Deferred, std::memory_order_relaxed);
+                return tree;
+            }
+
+            /// \brief true for a container whose children have not been parsed yet
+            inline bool isDeferred() const {
+                return (pending_.load(std::memory_order_acquire) == Pending::Deferred);
+            }
+
+            /// \brief array of count numbers held in one contiguous buffer instead of child
+            /// nodes. write() emits it in one loop and j2v() copies it straight into a
+            /// std::vector, the child nodes are only created when something accesses them,
+            /// once, like the children of a lazy parse, see expand(). v2j() never builds one
+            template <typename ValT>
+            static inline Tree packed(const ValT* data, const size_t& count) {
+                Tree tree(DataType::Array);
+                auto& buf = tree.value.emplace<string_t>();
+                buf.resize(1 + (count * sizeof(ValT)));
+                buf[0] = static_cast<char>(packedTypeOf<ValT>());
+                if(count > 0){
+                    std::memcpy(&buf[1], data, count * sizeof(ValT));
+                }
+                tree.pending_.store(Pending::Packed, std::memory_order_relaxed);
+                return tree;
+            }
+
+            /// \brief true for an array whose elements are still in a packed buffer
+            inline bool isPacked() const {
+                return (pending_.load(std::memory_order_acquire) == Pending::Packed);
+            }
+
+            /// \brief element type of a packed array
+            inline Packed packedType() const {
+                return static_cast<Packed>(std::get<string_t>(value)[0]);
+            }
+
+            /// \brief elements of a packed array in host byte order
+            inline std::string_view packedData() const {
+                return std::string_view(std::get<string_t>(value)).substr(1);
+            }
+
+            /// \brief append the elements of a packed array to out, see unpackElements()
+            template <typename ValT>
+            inline void unpack(std::vector<ValT>& out) const {
+                auto data = packedData();
+                unpackElements(packedType(), data.data(), data.size() / packedWidth(packedType()), out);
+            }
+
+            /// \brief parse the children of a deferred container, one level deep, or
+            /// create those of a packed array. every accessor does this first. a node is
+            /// expanded once, under a lock, so it can be read from several threads and
+            /// through a const Tree like any other
+            inline void expand() const {
+                if(pending_.load(std::memory_order_acquire) != Pending::None) {
+                    expandPending();
+                }
+            }
+
+            /// \brief memory resource all storage of this node comes from
+            inline std::pmr::memory_resource* resource() const {
+                return children_.get_allocator().resource();
+            }
+
+            /// \brief integer types match either integer alternative, float and double match float_t
             template <typename ValT>
             inline auto isValue() const {
-                return ((dataType_ == DataType::Value) && std::holds_alternative<ValT>(value));
+                if constexpr (std::is_integral<ValT>::value && !std::is_same<ValT, bool_t>::value) {
+                    return ((dataType_ == DataType::Value) && (std::holds_alternative<integer_t>(value) || std::holds_alternative<uinteger_t>(value)));
+                } else if constexpr (std::is_floating_point<ValT>::value) {
+                    return ((dataType_ == DataType::Value) && std::holds_alternative<float_t>(value));
+                } else {
+                    return ((dataType_ == DataType::Value) && std::holds_alternative<ValT>(value));
+                }
             }
 
             inline bool isNull() const {
@@ -105,184 +652,1080 @@ namespace posdk {
                 if(!isContainer()) {
                     throw posdk::JsonError("attempting to iterate-begin on non-container");
                 }
-                return items_.begin();
+                expand();
+                return iterator(this, 0);
             }
 
             inline iterator end() const {
                 if(!isContainer()) {
                     throw posdk::JsonError("attempting to iterate-end on non-container");
                 }
-                return items_.end();
+                expand();
+                return iterator(this, children_.size());
             }
 
             inline auto size() const {
                 if(!isContainer()) {
                     throw posdk::JsonError("attempting to get size on non-container");
                 }
-                return items_.size();
+                expand();
+                return children_.size();
             }
 
             inline auto& items() const {
                 if(!isContainer()) {
                     throw posdk::JsonError("attempting to get items on non-container");
                 }
-                return items_;
+                return *this;
+            }
+
+            /// \brief key of the idx'th child, empty for array elements
+            inline std::string_view keyAt(const size_t& idx) const {
+                if(dataType_ != DataType::Object) {
+                    return std::string_view();
+                }
+                expand();
+                return keys_[idx].view();
+            }
+
+            /// \brief idx'th child of a container
+            inline const Tree& at(const size_t& idx) const {
+                if(!isContainer()) {
+                    throw posdk::JsonError("attempting to index non-container");
+                }
+                expand();
+                return children_.at(idx);
             }
 
+            /// \brief pre-allocate room for count children
+            inline void reserve(const size_t& count) {
+                expand();
+                children_.reserve(count);
+                if(dataType_ == DataType::Object) {
+                    keys_.reserve(count);
+                }
+            }
+
+            /// \brief the value as ValT. integers are range-checked into any integer
+            /// type, floating point types also accept integer values
             template <typename ValT>
             inline auto getValue() const {
                 if(dataType_ != DataType::Value) {
                     throw posdk::JsonError("attempting to get value on non-value");
                 }
-                if(!isValue<ValT>()){
+                if constexpr (std::is_integral<ValT>::value && !std::is_same<ValT, bool_t>::value) {
+                    return getInteger<ValT>();
+                } else if constexpr (std::is_floating_point<ValT>::value) {
+                    if(std::holds_alternative<integer_t>(value)){
+                        return static_cast<ValT>(std::get<integer_t>(value));
+                    }
+                    if(std::holds_alternative<uinteger_t>(value)){
+                        return static_cast<ValT>(std::get<uinteger_t>(value));
+                    }
+                    if(!std::holds_alternative<float_t>(value)){
+                        throw posdk::JsonError("unexpected value type in JSON node");
+                    }
+                    return static_cast<ValT>(std::get<float_t>(value));
+                } else {
+                    if(!isValue<ValT>()){
+                        throw posdk::JsonError("unexpected value type in JSON node");
+                    }
+                    return std::get<ValT>(value);
+                }
+            }
+
+            template <typename IntT>
+            inline IntT getInteger() const {
+                if(std::holds_alternative<uinteger_t>(value)){
+                    auto val = std::get<uinteger_t>(value);
+                    if(val > static_cast<uinteger_t>(std::numeric_limits<IntT>::max())){
+                        throw posdk::JsonError("integer out of range in JSON node");
+                    }
+                    return static_cast<IntT>(val);
+                }
+                if(!std::holds_alternative<integer_t>(value)){
                     throw posdk::JsonError("unexpected value type in JSON node");
                 }
-                return std::get<ValT>(value);
+                auto val = std::get<integer_t>(value);
+                if(std::is_signed<IntT>::value){
+                    if((val < static_cast<integer_t>(std::numeric_limits<IntT>::min())) || (val > static_cast<integer_t>(std::numeric_limits<IntT>::max()))){
+                        throw posdk::JsonError("integer out of range in JSON node");
+                    }
+                }else if((val < 0) || (static_cast<uinteger_t>(val) > static_cast<uinteger_t>(std::numeric_limits<IntT>::max()))){
+                    throw posdk::JsonError("integer out of range in JSON node");
+                }
+                return static_cast<IntT>(val);
             }
 
-            std::map<std::string, Tree*>::const_iterator find(const std::string& key) const;
+            /// \brief string value without copying it, valid as long as this node
+            /// (and, for borrowed strings, the input buffer) is alive
+            inline std::string_view getStringView() const;
+
+            iterator find(const std::string_view& key) const;
 
             template <typename ValT>
-            inline ValT get(const std::string& key) const {
+            inline ValT get(const std::string_view& key) const {
                 if(key.size() == 0) {
                     throw posdk::JsonError("key length is zero");
                 }
                 if(dataType_ != DataType::Object) {
-                    throw posdk::JsonError("attempting to get key {0} on non-object", key);
+                    throw posdk::JsonError("attempting to get key {0} on non-object", std::string(key));
                 }
                 auto vit = find(key);
-                return vit->second->getValue<ValT>();
+                return vit->second.getValue<ValT>();
             }
 
-            inline Tree& getChild(const std::string& key) const {
+            inline Tree& getChild(const std::string_view& key) const {
                 if(key.size() == 0) {
                     throw posdk::JsonError("key length is zero");
                 }
                 if(dataType_ != DataType::Object) {
-                    throw posdk::JsonError("attempting to get child {0} on non-object", key);
+                    throw posdk::JsonError("attempting to get child {0} on non-object", std::string(key));
                 }
                 auto vit = find(key);
-                return *(vit->second);
+                return const_cast<Tree&>(vit->second);
             }
 
-            inline const Tree* hasChild(const std::string& key) const {
+            inline const Tree* hasChild(const std::string_view& key) const {
                 if(key.size() == 0) {
                     throw posdk::JsonError("key length is zero");
                 }
                 if(dataType_ != DataType::Object){
                     return nullptr;
                 }
-                auto vit = names.find(key);
-                if(vit == names.end()){
+                auto idx = indexOf(key);
+                if(idx == children_.size()){
                     return nullptr;
                 }
-                const Tree& tree = *vit->second;
-                return &tree;
+                return &children_[idx];
             }
 
             template <typename ValT>
-            inline Tree& add(const std::string& key, const ValT& val) {
+            inline Tree& add(const std::string_view& key, const ValT& val) {
+                return add(key, Tree(val));
+            }
+
+            inline Tree& add(const std::string_view& key, const Tree& val) {
+                return add(key, Tree(val, resource()));
+            }
+
+            inline Tree& add(const std::string_view& key, Tree&& val) {
                 if(key.size() == 0) {
                     throw posdk::JsonError("key length is zero");
                 }
                 if(dataType_ != DataType::Object){
-                    throw posdk::JsonError("attempting to add child {0} on non-object", key);
+                    throw posdk::JsonError("attempting to add child {0} on non-object", std::string(key));
                 }
-                items_.push_back(std::make_pair(key, Tree(val)));
-                Tree& t = items_.back().second;
-                names[key] = &t;
-                return t;
+                return addKey(makeKey(key, resource()), std::move(val));
             }
 
-            inline Tree& add(const std::string& key, const Tree& val) {
+            /// \brief add a child whose key bytes are referenced, not copied.
+            /// they must outlive this tree, see ParseOptions::borrowStrings
+            inline Tree& addBorrowed(const std::string_view& key, Tree&& val) {
                 if(key.size() == 0) {
                     throw posdk::JsonError("key length is zero");
                 }
                 if(dataType_ != DataType::Object){
-                    throw posdk::JsonError("attempting to add child {0} on non-object", key);
+                    throw posdk::JsonError("attempting to add child {0} on non-object", std::string(key));
                 }
-                items_.push_back(std::make_pair(key, val));
-                Tree& t = items_.back().second;
-                names[key] = &t;
-                return t;
+                return addKey(Key{hashKey(key), static_cast<uint32_t>(key.size()), 1, key.data()}, std::move(val));
             }
 
-            inline auto& add(const std::string& key, const char* val) {
-                return add<std::string>(key, std::string(val));
+        private:
+            inline Tree& addKey(Key&& key, Tree&& val) {
+                expand();
+                return appendKey(std::move(key), std::move(val));
             }
 
-            template <typename ValT>
-            inline void set(const std::string& key, const ValT& val) {
-                if(dataType_ != DataType::Object){
-                    throw posdk::JsonError("attempting to erase child {0} on non-object", key);
+            /// \brief addKey() without expand(), for the expansion itself
+            inline Tree& appendKey(Key&& key, Tree&& val) const {
+                keys_.push_back(std::move(key));
+                if(val.resource() == resource()){
+                    children_.push_back(std::move(val));
+                }else{
+                    children_.emplace_back(val, resource());
                 }
-                for(auto iit = items_.begin(), iite = items_.end(); iit != iite; ++iit){
-                    if(iit->first == key){
-                        iit->second = Tree(val);
-                        return;
+                if(slots_ != nullptr){
+                    if(keys_.size() * 2 > slotCount_){
+                        reindex();
+                    }else{
+                        indexInsert(keys_.size() - 1);
                     }
+                }else if(keys_.size() > IndexThreshold){
+                    reindex();
                 }
-                throw posdk::JsonError("attempting to set non-existent key: {0}", key);
+                return children_.back();
+            }
+
+        public:
+            inline auto& add(const std::string_view& key, const char* val) {
+                return add<std::string>(key, std::string(val));
+            }
+
+            template <typename ValT>
+            inline void set(const std::string_view& key, const ValT& val) {
+                set(key, Tree(val));
             }
 
-            inline void set(const std::string& key, const Tree& val) {
+            inline void set(const std::string_view& key, const Tree& val) {
+                set(key, Tree(val, resource()));
+            }
+
+            inline void set(const std::string_view& key, Tree&& val) {
                 if(dataType_ != DataType::Object){
-                    throw posdk::JsonError("attempting to erase child {0} on non-object", key);
+                    throw posdk::JsonError("attempting to erase child {0} on non-object", std::string(key));
                 }
-                for(auto iit = items_.begin(), iite = items_.end(); iit != iite; ++iit){
-                    if(iit->first == key){
-                        iit->second = val;
-                        return;
-                    }
+                auto idx = indexOf(key);
+                if(idx == children_.size()){
+                    throw posdk::JsonError("attempting to set non-existent key: {0}", std::string(key));
                 }
-                throw posdk::JsonError("attempting to set non-existent key: {0}", key);
+                children_[idx] = std::move(val);
             }
 
             template <typename ValT>
-            inline void add(const ValT& val) {
-                if(dataType_ != DataType::Array){
-                    throw posdk::JsonError("attempting to add item on non-array");
-                }
-                items_.push_back(std::make_pair("", Tree(val)));
+            inline Tree& add(const ValT& val) {
+                return add(Tree(val));
             }
 
-            inline void add(const Tree& val) {
+            inline Tree& add(const Tree& val) {
+                return add(Tree(val, resource()));
+            }
+
+            inline Tree& add(Tree&& val) {
                 if(dataType_ != DataType::Array){
                     throw posdk::JsonError("attempting to add item on non-array");
                 }
-                items_.push_back(std::make_pair("", val));
+                expand();
+                if(val.resource() == resource()){
+                    children_.push_back(std::move(val));
+                }else{
+                    children_.emplace_back(val, resource());
+                }
+                return children_.back();
             }
 
-            inline void erase(const std::string& key) {
+            inline void erase(const std::string_view& key) {
                 if(dataType_ != DataType::Object){
-                    throw posdk::JsonError("attempting to erase child {0} on non-object", key);
+                    throw posdk::JsonError("attempting to erase child {0} on non-object", std::string(key));
                 }
-                for(auto iit = items_.begin(), iite = items_.end(); iit != iite; ++iit){
-                    if(iit->first == key){
-                        items_.erase(iit);
-                        break;
-                    }
-                }
-                auto vit = names.find(key);
-                if(vit != names.end()){
-                    names.erase(key);
+                auto idx = indexOf(key);
+                if(idx == children_.size()){
+                    return;
                 }
+                children_.erase(children_.begin() + static_cast<std::ptrdiff_t>(idx));
+                freeKey(keys_[idx]);
+                keys_.erase(keys_.begin() + static_cast<std::ptrdiff_t>(idx));
+                reindex();
             }
 
             void print(std::ostream& os, const size_t& lvl, const size_t& indent) const;
 
+            /// \brief serialise this node and its descendants into writer
+            void write(Writer& writer) const;
+
+        private:
+            /// \brief keys_ of a deferred container, which holds no keys until it is
+            /// parsed, keep the input name and start for error messages
+            inline void setSource(const std::string_view& name, const char* input) const {
+                keys_.reserve(2);
+                keys_.push_back(makeKey(name, resource()));
+                keys_.push_back(Key{0, 0, 1, input});
+            }
+
+            void expandPending() const;
+            void parseDeferred() const;
+            void unpackChildren() const;
+            /// \brief recurses for ordinary trees, deeply nested ones are taken apart with a worklist
+            void destroyChildren();
+        };
+
+        // std::vector only relocates children by move when the move cannot throw
+        static_assert(std::is_nothrow_move_constructible<Tree>::value, "Json::Tree must be nothrow movable");
+
+        /// \brief destination for serialised output, e.g. a file or a socket
+        /// the Writer hands its buffer over in large chunks
+        class Sink {
+        public:
+            virtual ~Sink() {}
+            virtual void write(const char* data, const size_t& size) = 0;
+        };
+
+        /// \brief Sink writing into a std::ostream
+        class OstreamSink : public Sink {
+            std::ostream& os_;
+
+        public:
+            explicit inline OstreamSink(std::ostream& os) : os_(os) {}
+
+            inline void write(const char* data, const size_t& size) override {
+                os_.write(data, static_cast<std::streamsize>(size));
+            }
+        };
+
+        /// \brief wire format written by a Writer and read as set in ParseOptions
+        enum class Encoding {
+            Json,
+            /// \brief RFC 8949 CBOR. objects and arrays are written with indefinite lengths,
+            /// so they can be streamed token by token like Json
+            Cbor,
+        };
+
+        /// \brief serialises Json tokens into a contiguous buffer
+        /// without a sink the whole document collects in the buffer, see view() and release().
+        /// with a sink the buffer is handed over whenever it grows past flushSize, and on flush().
+        /// clear() keeps the capacity, so one Writer can be reused for many documents.
+        /// indent is the number of spaces per level, 0 writes compact output.
+        /// tokens must be well-formed: a key() before every value inside an object.
+        /// with Encoding::Cbor the same tokens are written as CBOR data items
+        class Writer {
+            std::string buf_;
+            Sink* sink_;
+            Encoding encoding_;
+            size_t indent_;
+            size_t flushSize_;
+            size_t depth_;
+            /// \brief nothing written yet at the current level
+            bool first_;
+            /// \brief a key was just written, its value follows without a separator
+            bool afterKey_;
+            /// \brief see packArrays()
+            bool packArrays_;
+            /// \brief "\n" followed by the spaces for the deepest level seen so far
+            std::string newline_;
+
+            inline void newline(const size_t& depth) {
+                if(indent_ == 0){
+                    return;
+                }
+                auto len = 1 + (depth * indent_);
+                if(newline_.size() < len){
+                    newline_.resize(len * 2, ' ');
+                    newline_[0] = '\n';
+                }
+                buf_.append(newline_.data(), len);
+            }
+
+            /// \brief comma and indentation before an array element or object key
+            inline void separator() {
+                if(afterKey_){
+                    afterKey_ = false;
+                    return;
+                }
+                if(depth_ == 0){
+                    return;
+                }
+                if(!first_){
+                    buf_ += ',';
+                }
+                newline(depth_);
+                first_ = false;
+            }
+
+            inline void flushIfFull() {
+                if((sink_ != nullptr) && (buf_.size() >= flushSize_)){
+                    flush();
+                }
+            }
+
+            /// \brief str quoted and escaped per RFC 8259, non-ASCII bytes are copied as they are
+            void appendString(const std::string_view& str);
+            void appendNumber(const integer_t& val);
+            void appendNumber(const uinteger_t& val);
+            void appendNumber(const float_t& val);
+            void appendNumber(const float& val);
+
+            /// \brief CBOR head: major type in the top 3 bits, then the shortest form of arg
+            void appendCborHead(const uint8_t& major, const uint64_t& arg);
+            void appendCbor(const integer_t& val);
+            void appendCbor(const float_t& val);
+
+            inline void appendCbor(const std::string_view& str) {
+                appendCborHead(3, str.size());
+                buf_.append(str.data(), str.size());
+            }
+
+            inline bool cbor() const {
+                return (encoding_ == Encoding::Cbor);
+            }
+
+        public:
+            explicit inline Writer(const size_t& indent = 2)
+            : sink_(nullptr), encoding_(Encoding::Json), indent_(indent), flushSize_(0), depth_(0), first_(true), afterKey_(false), packArrays_(false) {}
+
+            explicit inline Writer(Sink& sink, const size_t& indent = 2, const size_t& flushSize = 64 * 1024)
+            : sink_(&sink), encoding_(Encoding::Json), indent_(indent), flushSize_(flushSize), depth_(0), first_(true), afterKey_(false), packArrays_(false) {
+                buf_.reserve(flushSize + 1024);
+            }
+
+            /// \brief compact output in encoding
+            explicit inline Writer(const Encoding& encoding)
+            : sink_(nullptr), encoding_(encoding), indent_(0), flushSize_(0), depth_(0), first_(true), afterKey_(false), packArrays_(false) {}
+
+            explicit inline Writer(Sink& sink, const Encoding& encoding, const size_t& flushSize = 64 * 1024)
+            : sink_(&sink), encoding_(encoding), indent_(0), flushSize_(flushSize), depth_(0), first_(true), afterKey_(false), packArrays_(false) {
+                buf_.reserve(flushSize + 1024);
+            }
+
+            Writer(const Writer&) = delete;
+            Writer& operator=(const Writer&) = delete;
+
+            inline void beginObject() {
+                if(cbor()){
+                    buf_ += '\xbf';
+                    return;
+                }
+                separator();
+                buf_ += '{';
+                ++depth_;
+                first_ = true;
+            }
+
+            inline void endObject() {
+                if(cbor()){
+                    buf_ += '\xff';
+                    flushIfFull();
+                    return;
+                }
+                --depth_;
+                if(!first_){
+                    newline(depth_);
+                }
+                buf_ += '}';
+                first_ = false;
+                flushIfFull();
+            }
+
+            inline void beginArray() {
+                if(cbor()){
+                    buf_ += '\x9f';
+                    return;
+                }
+                separator();
+                buf_ += '[';
+                ++depth_;
+                first_ = true;
+            }
+
+            inline void endArray() {
+                if(cbor()){
+                    buf_ += '\xff';
+                    flushIfFull();
+                    return;
+                }
+                --depth_;
+                if(!first_){
+                    newline(depth_);
+                }
+                buf_ += ']';
+                first_ = false;
+                flushIfFull();
+            }
+
+            inline void key(const std::string_view& k) {
+                if(cbor()){
+                    appendCbor(k);
+                    return;
+                }
+                separator();
+                appendString(k);
+                buf_ += ':';
+                afterKey_ = true;
+            }
+
+            inline void null() {
+                if(cbor()){
+                    buf_ += '\xf6';
+                    flushIfFull();
+                    return;
+                }
+                separator();
+                buf_ += "null";
+                flushIfFull();
+            }
+
+            inline void value(const bool_t& val) {
+                if(cbor()){
+                    buf_ += (val?'\xf5':'\xf4');
+                    flushIfFull();
+                    return;
+                }
+                separator();
+                buf_ += (val?"true":"false");
+                flushIfFull();
+            }
+
+            inline void value(const integer_t& val) {
+                if(cbor()){
+                    appendCbor(val);
+                    flushIfFull();
+                    return;
+                }
+                separator();
+                appendNumber(val);
+                flushIfFull();
+            }
+
+            inline void value(const uinteger_t& val) {
+                if(cbor()){
+                    appendCborHead(0, val);
+                    flushIfFull();
+                    return;
+                }
+                separator();
+                appendNumber(val);
+                flushIfFull();
+            }
+
+            inline void value(const float_t& val) {
+                if(cbor()){
+                    appendCbor(val);
+                    flushIfFull();
+                    return;
+                }
+                separator();
+                appendNumber(val);
+                flushIfFull();
+            }
+
+            /// \brief Json text gets the shortest form that reads back as the same float,
+            /// 12.3 for 12.3f. CBOR stores the exact value, as single precision
+            inline void value(const float& val) {
+                if(cbor()){
+                    appendCbor(static_cast<float_t>(val));
+                    flushIfFull();
+                    return;
+                }
+                separator();
+                appendNumber(val);
+                flushIfFull();
+            }
+
+            /// \brief any other integer type: int, long long, unsigned, char...
+            template <typename IntT, typename std::enable_if<std::is_integral<IntT>::value && !std::is_same<IntT, bool_t>::value, int>::type = 0>
+            inline void value(const IntT& val) {
+                if(std::is_signed<IntT>::value){
+                    value(static_cast<integer_t>(val));
+                }else{
+                    value(static_cast<uinteger_t>(val));
+                }
+            }
+
+            inline void value(const std::string_view& val) {
+                if(cbor()){
+                    appendCbor(val);
+                    flushIfFull();
+                    return;
+                }
+                separator();
+                appendString(val);
+                flushIfFull();
+            }
+
+            inline void value(const std::string& val) {
+                value(std::string_view(val));
+            }
+
+            inline void value(const char* val) {
+                value(std::string_view(val));
+            }
+
+            inline void value(const Tree& tree) {
+                tree.write(*this);
+            }
+
+            /// \brief write packed numeric arrays, from Tree::packed() or a serialised
+            /// std::vector, as {"__packed__":"f32","__data__":"<base64>"} instead of a
+            /// Json array. the bytes are in host order, so only little endian hosts
+            /// should exchange them. the serialiser reads both forms back
+            inline void packArrays(const bool& on) {
+                packArrays_ = on;
+            }
+
+            inline bool packArrays() const {
+                return packArrays_;
+            }
+
+            /// \brief an array of count elements of type stored at data, see packArrays()
+            void packed(const Packed& type, const char* data, const size_t& count);
+
+            template <typename ValT>
+            inline void values(const ValT* data, const size_t& count) {
+                packed(packedTypeOf<ValT>(), reinterpret_cast<const char*>(data), count);
+            }
+
+            /// \brief end a top level value with a newline, for writing one record
+            /// per line (NDJSON). use an indent of 0 so the records stay on one line
+            inline void endLine() {
+                // a CBOR sequence needs no separator between items
+                if(!cbor()){
+                    buf_ += '\n';
+                }
+                first_ = true;
+                flushIfFull();
+            }
+
+            /// \brief continue at nesting level lvl, for writing a value that is
+            /// embedded in a document written elsewhere
+            inline void nest(const size_t& lvl) {
+                depth_ = lvl;
+                afterKey_ = (lvl > 0);
+            }
+
+            /// \brief hand everything buffered so far to the sink
+            inline void flush() {
+                if((sink_ != nullptr) && !buf_.empty()){
+                    sink_->write(buf_.data(), buf_.size());
+                    buf_.clear();
+                }
+            }
+
+            /// \brief start a new document, keeping the buffer capacity
+            inline void clear() {
+                buf_.clear();
+                depth_ = 0;
+                first_ = true;
+                afterKey_ = false;
+            }
+
+            inline std::string_view view() const {
+                return std::string_view(buf_);
+            }
+
+            /// \brief move the buffered output out of the writer
+            inline std::string release() {
+                std::string str;
+                str.swap(buf_);
+                clear();
+                return str;
+            }
+        };
+
+        /// \brief parser settings
+        struct ParseOptions {
+            /// \brief string values and keys without escapes point into the input
+            /// buffer instead of being copied. the buffer must outlive the tree,
+            /// copies of the tree own their strings again
+            bool borrowStrings = false;
+
+            /// \brief index all structural chars with SIMD in a first pass, then build
+            /// the tree by jumping from token to token instead of running the
+            /// byte-at-a-time state machine. documents of 4GB and more are parsed by the
+            /// state machine, the index holds 32 bit offsets
+            bool structuralIndex = false;
+
+            /// \brief format of the input. Cbor is read by load(), parse() and Reader,
+            /// the line and push parsers read Json only. lazy and structuralIndex
+            /// apply to Json, borrowStrings to definite length CBOR strings
+            Encoding encoding = Encoding::Json;
+
+            /// \brief load() parses the top level only, nested containers keep their text
+            /// and parse it, one level at a time, the first time their children are
+            /// accessed. the buffer must outlive the tree and strings are borrowed from it.
+            /// errors inside a nested container are found when it is first accessed and
+            /// report their position in the whole buffer.
+            /// a container is parsed once, under a lock, so a lazy tree can be read from
+            /// several threads, and through a const Tree, like any other.
+            /// the readers and parsers that do not build a Tree through load() ignore it
+            bool lazy = false;
+        };
+
+        /// \brief what a Reader is positioned on after next()
+        enum class Token {
+            BeginObject,
+            EndObject,
+            BeginArray,
+            EndArray,
+            Key,
+            Value,
+            End,
+        };
+
+        /// \brief pull parser, reads a document one token at a time without building a Tree
+        /// after a Key token key() holds the key, valid until the next key is read.
+        /// after a Value token value() holds the scalar, strings borrowed from the input
+        /// or the reader, valid until the next call to next().
+        /// the buffer must outlive the reader.
+        class Reader {
+            struct State;
+            std::unique_ptr<State> state_;
+
+        public:
+            explicit Reader(const std::string_view& buf, const std::string& filename = "<str>", const ParseOptions& opts = ParseOptions());
+            ~Reader();
+
+            Reader(const Reader&) = delete;
+            Reader& operator=(const Reader&) = delete;
+
+            /// \brief the token next() will return, without consuming it
+            Token peek();
+
+            Token next();
+
+            /// \brief next() that throws unless it returns tok
+            void expect(const Token& tok);
+
+            /// \brief throws unless the document has been read and only whitespace follows it
+            void expectEnd();
+
+            const std::string_view& key() const;
+            const Tree& value() const;
+
+            /// \brief skip the next value, with everything nested in it
+            void skip();
+
+            /// \brief read the next value, with everything nested in it, into tree
+            void read(Tree& tree);
+
+            /// \brief start over on a new buffer, keeping the allocations made so far
+            /// line is the row of the buffer in its file, for error messages
+            void reset(const std::string_view& buf, const size_t& line = 1);
+
+            /// \brief bytes of the buffer read so far
+            size_t offset() const;
+
+            /// \brief file(row,col) of the current position, for error messages
+            std::string pos() const;
         };
 
+        /// \brief receives the parse events of a document, see parse()
+        /// the members do nothing by default, override the ones needed.
+        /// string and key views are only valid during the call
+        class Handler {
+        public:
+            virtual ~Handler() {}
+            virtual void beginObject() {}
+            virtual void endObject() {}
+            virtual void beginArray() {}
+            virtual void endArray() {}
+            virtual void key(const std::string_view&) {}
+            virtual void null() {}
+            virtual void value(const bool_t&) {}
+            virtual void value(const integer_t&) {}
+            virtual void value(const uinteger_t&) {}
+            virtual void value(const float_t&) {}
+            virtual void value(const std::string_view&) {}
+        };
+
+        /// \brief parse Json text from a contiguous buffer into handler events, without building a Tree
+        void parse(const std::string_view& buf, const std::string& filename, Handler& handler, const ParseOptions& opts = ParseOptions());
+
+        /// \brief push parser, takes a document in chunks of any size as they arrive
+        /// events are reported to the handler, or the tree is built, as soon as
+        /// their bytes are in. a chunk need not outlive the feed() call, so strings
+        /// are always copied into the tree and borrowStrings is ignored.
+        /// only whitespace may follow the document
+        class PushParser {
+            struct State;
+            std::unique_ptr<State> state_;
+
+        public:
+            enum class Status {
+                NeedMore,
+                Complete,
+            };
+
+            explicit PushParser(Handler& handler, const std::string& filename = "<str>", const ParseOptions& opts = ParseOptions());
+            explicit PushParser(Tree& tree, const std::string& filename = "<str>", const ParseOptions& opts = ParseOptions());
+            ~PushParser();
+
+            PushParser(const PushParser&) = delete;
+            PushParser& operator=(const PushParser&) = delete;
+
+            Status feed(const char* data, const size_t& size);
+
+            inline Status feed(const std::string_view& buf) {
+                return feed(buf.data(), buf.size());
+            }
+
+            /// \brief end of input, throws if the document is incomplete
+            /// needed for a top level number, which can not end before it
+            Status finish();
+        };
+
+        /// \brief load Json text from a contiguous buffer into posdk::Json::Tree structure
+        void load(const std::string_view& buf, const std::string& filename, Tree& tree, const ParseOptions& opts = ParseOptions());
+
         /// \brief load Json string into posdk::Json::Tree structure
+        /// the stream is read up to the end of the value into a buffer and parsed from
+        /// there, anything after the value is left in the stream
         void load(std::istream& in, const std::string& filename, Tree& tree);
-        inline void save(std::ostream& os, const Tree& tree, const size_t& indent = 2){
-            tree.print(os, 0, indent);
-        }
+        /// \brief write tree as Json text, indented by 2 spaces per level unless indent is 0
+        void save(std::ostream& os, const Tree& tree, const size_t& indent = 2);
+
+        Tree loadFromString(const std::string& str, const ParseOptions& opts = ParseOptions());
+
+        /// \brief bump allocator that parsed documents live in
+        /// everything loaded into an arena is released at once by reset(). the first
+        /// block is kept across resets, so a per-thread arena can be reused per request.
+        class Arena {
+            std::unique_ptr<std::byte[]> initial_;
+            std::pmr::monotonic_buffer_resource resource_;
+
+        public:
+            explicit inline Arena(const size_t& initialSize = 64 * 1024)
+            : initial_(new std::byte[initialSize])
+            , resource_(initial_.get(), initialSize, std::pmr::new_delete_resource())
+            {}
+
+            Arena(const Arena&) = delete;
+            Arena& operator=(const Arena&) = delete;
+
+            inline std::pmr::memory_resource* resource() {
+                return &resource_;
+            }
+
+            /// \brief release all trees loaded into this arena, in O(1)
+            inline void reset() {
+                resource_.release();
+            }
+        };
 
-        Tree loadFromString(const std::string& str);
+        /// \brief load Json string into a Tree allocated from arena
+        /// the tree belongs to the arena: it is never destroyed, arena.reset() frees it
+        Tree& loadFromString(const std::string& str, Arena& arena, const ParseOptions& opts = ParseOptions());
+        /// \brief tree as Json text, indented by 2 spaces per level unless indent is 0
         std::string saveToString(const Tree& tree, const size_t& indent = 2);
 
+        /// \brief compact output in encoding, e.g. Encoding::Cbor
+        std::string saveToString(const Tree& tree, const Encoding& encoding);
+
+        /// \brief read-only view over the contents of a file
+        /// regular files are memory-mapped, pipes and special files are read into a buffer.
+        /// keep the object alive for as long as anything refers into data()
+        class MappedFile {
+            std::string filename_;
+            const char* data_;
+            size_t size_;
+            bool mapped_;
+            std::string buffer_;
+
+        public:
+            explicit MappedFile(const std::string& filename);
+            ~MappedFile();
+
+            MappedFile(const MappedFile&) = delete;
+            MappedFile& operator=(const MappedFile&) = delete;
+
+            inline const std::string& filename() const {
+                return filename_;
+            }
+
+            inline const char* data() const {
+                return data_;
+            }
+
+            inline size_t size() const {
+                return size_;
+            }
+
+            inline std::string_view view() const {
+                return std::string_view(data_, size_);
+            }
+
+            inline bool mapped() const {
+                return mapped_;
+            }
+        };
+
+        /// \brief reads newline-delimited Json (NDJSON), one value per line
+        /// empty lines are skipped and a trailing '\r' is dropped. a stream is read in
+        /// blocks into one buffer that is reused for every line, so memory stays at
+        /// about the block size or the longest line. lines, and strings borrowed from
+        /// them, are valid until the next call for a stream, and for as long as the
+        /// buffer or file for the others. borrowStrings is ignored for a stream
+        class LineReader {
+            struct State;
+            std::unique_ptr<State> state_;
+
+        public:
+            /// firstLine is the row of the first line of buf, when buf is part of a file
+            explicit LineReader(const std::string_view& buf, const std::string& filename = "<str>", const ParseOptions& opts = ParseOptions(), const size_t& firstLine = 1);
+            explicit LineReader(const MappedFile& file, const ParseOptions& opts = ParseOptions());
+            explicit LineReader(std::istream& in, const std::string& filename = "<stream>", const ParseOptions& opts = ParseOptions(), const size_t& blockSize = 64 * 1024);
+            ~LineReader();
+
+            LineReader(const LineReader&) = delete;
+            LineReader& operator=(const LineReader&) = delete;
+
+            /// \brief the next line as it is, false at the end
+            bool next(std::string_view& line);
+
+            /// \brief parse the next line into tree, false at the end
+            bool next(Tree& tree);
+
+            /// \brief parse the next line into handler events, false at the end
+            bool next(Handler& handler);
+
+            /// \brief a Reader over the next line, nullptr at the end
+            /// the same Reader is reset for every line. call Reader::expectEnd() after
+            /// the value to reject anything else on the line, as next() does
+            Reader* nextReader();
+
+            /// \brief row of the last line returned
+            size_t line() const;
+        };
+
+        /// \brief how NDJSON is split over threads
+        struct ParallelOptions {
+            /// \brief worker threads, 0 for one per core
+            size_t threads = 0;
+
+            /// \brief bytes of input per task, the cut is made at the next line end
+            size_t chunkSize = 1024 * 1024;
+
+            /// \brief deliver records in input order on the calling thread, otherwise
+            /// in the order they are parsed, on the worker threads
+            bool ordered = true;
+        };
+
+        /// \brief runs tasks over the line-aligned chunks of an NDJSON buffer on a pool of threads
+        /// work(slot, text, firstLine) parses a chunk into the results kept in slot, then
+        /// done(slot) hands them on: in input order on the calling thread if ordered, otherwise
+        /// right after work() on the same thread. each of the slots() slots is used by one
+        /// chunk at a time, which also bounds the memory held by parsed chunks.
+        /// the first exception stops the threads and is rethrown. a JsonError from work() is
+        /// thrown again by a rerun of work() with the file row of the chunk's first line,
+        /// firstLine is 1 otherwise, as counting rows would take a pass over the whole buffer
+        class LineChunks {
+            std::string_view buf_;
+            ParallelOptions opts_;
+            size_t threads_;
+
+        public:
+            explicit LineChunks(const std::string_view& buf, const ParallelOptions& opts = ParallelOptions());
+
+            inline size_t threads() const {
+                return threads_;
+            }
+
+            inline size_t slots() const {
+                return threads_ * 2;
+            }
+
+            void run(const std::function<void(const size_t& slot, const std::string_view& text, const size_t& firstLine)>& work, const std::function<void(const size_t& slot)>& done);
+        };
+
+        /// \brief parse NDJSON on several threads and call fn for each record
+        /// records are parsed into per-chunk arenas and are only valid during the call
+        void parseLines(const std::string_view& buf, const std::string& filename, const std::function<void(Tree&)>& fn, const ParseOptions& opts = ParseOptions(), const ParallelOptions& popts = ParallelOptions());
+
+        /// \brief runs tasks over the elements of a large top level array on a pool of threads
+        /// a prescan over the block masks of the structural index finds the commas between
+        /// top level elements and cuts the array into chunks of about chunkSize bytes.
+        /// element(slot, reader) is called with a Reader on each element of a chunk, it must read
+        /// that one value, into results kept in slot. done(slot) then hands them on as with
+        /// LineChunks, always in input order on the calling thread.
+        /// positions in errors are relative to the element, callers that need the position
+        /// in the buffer parse it again serially
+        class ArrayChunks {
+            std::string_view buf_;
+            std::string filename_;
+            ParseOptions opts_;
+            ParallelOptions popts_;
+            size_t threads_;
+            bool malformed_ = false;
+
+        public:
+            explicit ArrayChunks(const std::string_view& buf, const std::string& filename = "<str>", const ParseOptions& opts = ParseOptions(), const ParallelOptions& popts = ParallelOptions());
+
+            inline size_t threads() const {
+                return threads_;
+            }
+
+            inline size_t slots() const {
+                return threads_ * 2;
+            }
+
+            /// \brief false, without calling anything, if buf is not an array
+            bool run(const std::function<void(const size_t& slot, Reader& reader)>& element, const std::function<void(const size_t& slot)>& done);
+
+            /// \brief true if the last run() threw because the text of the array is not valid json,
+            /// false if it threw from element() or done() on valid text
+            inline bool malformed() const {
+                return malformed_;
+            }
+        };
+
+        /// \brief load a top level array on several threads, see ArrayChunks
+        /// anything else, and trees on an Arena, are loaded by load(). on a parse error the
+        /// buffer is loaded again by load(), which throws with the position in the buffer.
+        /// if load() succeeds, its tree is the result
+        void loadArray(const std::string_view& buf, const std::string& filename, Tree& tree, const ParseOptions& opts = ParseOptions(), const ParallelOptions& popts = ParallelOptions());
+
+        /// \brief a location in a document, compiled once and evaluated against any
+        /// number of trees, or over parse events with a PathSelector
+        class Path {
+        public:
+            /// \brief one reference token: a key, or an index when it is a valid array index
+            struct Step {
+                std::string key;
+                size_t index;
+            };
+
+        private:
+            std::vector<Step> steps_;
+
+        public:
+            static constexpr size_t NoIndex = static_cast<size_t>(-1);
+
+            /// \brief RFC 6901 Json Pointer, "" is the whole document, "/a/0/b~1c" is
+            /// key "a", element or key "0", then key "b/c"
+            static Path pointer(const std::string_view& ptr);
+
+            /// \brief dotted path, "" is the whole document, "a.b[2].c" is key "a",
+            /// key "b", element 2, then key "c". a name that is all digits also
+            /// indexes an array, as in a pointer
+            static Path dotted(const std::string_view& path);
+
+            inline const std::vector<Step>& steps() const {
+                return steps_;
+            }
+
+            /// \brief the node at this path in tree, nullptr if there is none
+            const Tree* find(const Tree& tree) const;
+
+            /// \brief the node at this path in tree, throws if there is none
+            const Tree& get(const Tree& tree) const;
+
+            /// \brief the value at this path in tree as ValT
+            template <typename ValT>
+            inline ValT get(const Tree& tree) const {
+                return get(tree).getValue<ValT>();
+            }
+        };
+
+        /// \brief extracts the values at a set of paths from parse events, building a Tree
+        /// for each of them and nothing else. feed it to parse(), a PushParser or a
+        /// LineReader. each new document clears the results of the previous one
+        class PathSelector : public Handler {
+            struct State;
+            std::unique_ptr<State> state_;
+
+        public:
+            explicit PathSelector(const std::vector<Path>& paths);
+            ~PathSelector();
+
+            PathSelector(const PathSelector&) = delete;
+            PathSelector& operator=(const PathSelector&) = delete;
+
+            /// \brief the value found at paths[idx] in the last document, nullptr if there was none
+            const Tree* result(const size_t& idx) const;
+
+            void beginObject() override;
+            void endObject() override;
+            void beginArray() override;
+            void endArray() override;
+            void key(const std::string_view& key) override;
+            void null() override;
+            void value(const bool_t& val) override;
+            void value(const integer_t& val) override;
+            void value(const uinteger_t& val) override;
+            void value(const float_t& val) override;
+            void value(const std::string_view& val) override;
+        };
+
         Tree loadFromFile(const std::string& filename);
+        Tree loadFromFile(const MappedFile& file, const ParseOptions& opts = ParseOptions());
         void saveToFile(const Tree& tree, const std::string& filename, const size_t& indent = 2);
 
         std::string encodeString(const std::string& str);
@@ -290,22 +1733,49 @@ namespace posdk {
      }
 
     template <>
-    inline auto Json::Tree::getValue<const char*>() const {
-        return getValue<std::string>();
+    inline auto Json::Tree::isValue<std::string>() const {
+        return ((dataType_ == DataType::Value) && (std::holds_alternative<string_t>(value) || std::holds_alternative<strview_t>(value)));
+    }
+
+    template <>
+    inline auto Json::Tree::getValue<std::string>() const {
+        if(dataType_ != DataType::Value) {
+            throw posdk::JsonError("attempting to get value on non-value");
+        }
+        if(std::holds_alternative<strview_t>(value)){
+            return std::string(std::get<strview_t>(value));
+        }
+        if(!std::holds_alternative<string_t>(value)){
+            throw posdk::JsonError("unexpected value type in JSON node");
+        }
+        return std::get<string_t>(value);
     }
 
     template <>
-    inline auto Json::Tree::getValue<size_t>() const {
-        return static_cast<size_t>(getValue<int64_t>());
+    inline auto Json::Tree::isValue<std::string_view>() const {
+        return isValue<std::string>();
     }
 
     template <>
-    inline auto Json::Tree::getValue<int>() const {
-        return getValue<int64_t>();
+    inline auto Json::Tree::getValue<std::string_view>() const {
+        if(dataType_ != DataType::Value) {
+            throw posdk::JsonError("attempting to get value on non-value");
+        }
+        if(std::holds_alternative<strview_t>(value)){
+            return std::get<strview_t>(value);
+        }
+        if(!std::holds_alternative<string_t>(value)){
+            throw posdk::JsonError("unexpected value type in JSON node");
+        }
+        return std::string_view(std::get<string_t>(value));
+    }
+
+    inline std::string_view Json::Tree::getStringView() const {
+        return getValue<std::string_view>();
     }
 
     template <>
-    inline auto Json::Tree::getValue<uint32_t>() const {
-        return static_cast<int64_t>(getValue<int64_t>());
+    inline auto Json::Tree::getValue<const char*>() const {
+        return getValue<std::string>();
     }
 }
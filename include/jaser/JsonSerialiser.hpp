@@ -1,6 +1,20 @@
 #pragma once
 #include "Json.hpp"
 #include <assert.h>
+#include <array>
+#include <tuple>
+#include <utility>
+
+/// \brief declare the members serialised by v2j()/j2v(), inside the class:
+///   struct Point { int x = 0; int y = 0; JASER_FIELDS(x, y) };
+/// each member is written under its own name, in this order. reading matches keys in
+/// that order first and through a hash table built at compile time otherwise, keys
+/// that are not fields are skipped and missing fields keep their default value.
+/// the class must be default constructible
+#define JASER_FIELDS(...) \
+    inline auto jfields() { return std::tie(__VA_ARGS__); } \
+    inline auto jfields() const { return std::tie(__VA_ARGS__); } \
+    static constexpr std::string_view jfieldNames() { return #__VA_ARGS__; }
 
 namespace posdk {
     /// \brief class representing Json
@@ -20,24 +34,216 @@ namespace posdk {
             struct specializer_variant : specializer_vector {};
             struct specializer_enum    : specializer_variant {};
             struct specializer_class   : specializer_enum {};
-            struct specializer         : specializer_class {};
+            struct specializer_fields  : specializer_class {};
+            struct specializer         : specializer_fields {};
 
             // used to check if class has method
             template<typename> struct int_ { typedef int type; };
 
+            // check if class has jsave(Tree&) and/or jsave(Writer&), either may be overloaded
+            template<typename ValT, typename = int>
+            struct has_jsave_tree : std::false_type {};
+
+            template<typename ValT>
+            struct has_jsave_tree<ValT, typename int_<decltype(std::declval<const ValT&>().jsave(std::declval<posdk::Json::Tree&>()))>::type> : std::true_type {};
+
+            template<typename ValT, typename = int>
+            struct has_jsave_writer : std::false_type {};
+
+            template<typename ValT>
+            struct has_jsave_writer<ValT, typename int_<decltype(std::declval<const ValT&>().jsave(std::declval<posdk::Json::Writer&>()))>::type> : std::true_type {};
+
+            // check if class has jload(Reader&, key)
+            template<typename ValT, typename = int>
+            struct has_jload : std::false_type {};
+
+            template<typename ValT>
+            struct has_jload<ValT, typename int_<decltype(std::declval<ValT&>().jload(std::declval<posdk::Json::Reader&>(), std::declval<const std::string_view&>()))>::type> : std::true_type {};
+
             // struct & classes
-            template<typename ValT, typename int_<decltype(&ValT::jsave)>::type = 0>
+            template<typename ValT, typename int_<decltype(std::declval<const ValT&>().jsave(std::declval<posdk::Json::Tree&>()))>::type = 0>
             inline ValT j2v(const posdk::Json::Tree& jval, const specializer_class&) {
                 return ValT(jval);
             }
 
-            template<typename ValT, typename int_<decltype(&ValT::jsave)>::type = 0>
+            template<typename ValT, typename int_<decltype(std::declval<const ValT&>().jsave(std::declval<posdk::Json::Tree&>()))>::type = 0>
             inline posdk::Json::Tree v2j(const ValT& val, const specializer_class&) {
                 posdk::Json::Tree jval(posdk::Json::DataType::Object);
                 val.jsave(jval);
                 return jval;
             }
 
+            /// \brief jload(Reader&, key) reads the members straight in, it returns false for
+            /// keys it does not know, which are skipped. classes without jload are
+            /// read into a Tree and constructed from that
+            template<typename ValT, typename = typename std::enable_if< has_jload<ValT>::value || has_jsave_tree<ValT>::value, ValT >::type>
+            inline ValT j2v(posdk::Json::Reader& reader, const specializer_class&) {
+                if constexpr (has_jload<ValT>::value) {
+                    ValT val;
+                    reader.expect(posdk::Json::Token::BeginObject);
+                    while(reader.next() == posdk::Json::Token::Key) {
+                        auto key = reader.key();
+                        if(!val.jload(reader, key)) {
+                            reader.skip();
+                        }
+                    }
+                    return val;
+                } else {
+                    posdk::Json::Tree jval;
+                    reader.read(jval);
+                    return ValT(jval);
+                }
+            }
+
+            /// \brief jsave(Writer&) writes the members straight out, classes with
+            /// only jsave(Tree&) go through a Tree
+            template<typename ValT, typename = typename std::enable_if< has_jsave_writer<ValT>::value || has_jsave_tree<ValT>::value, ValT >::type>
+            inline void v2j(posdk::Json::Writer& writer, const ValT& val, const specializer_class&) {
+                if constexpr (has_jsave_writer<ValT>::value) {
+                    writer.beginObject();
+                    val.jsave(writer);
+                    writer.endObject();
+                } else {
+                    posdk::Json::Tree jval(posdk::Json::DataType::Object);
+                    val.jsave(jval);
+                    writer.value(jval);
+                }
+            }
+
+            // looper (used in variant and JASER_FIELDS converters)
+            template<class T, T... inds, class F>
+            constexpr void loop_(std::integer_sequence<T, inds...>, F&& f) {
+                (f(std::integral_constant<T, inds>{}), ...);// C++17 fold expression
+            }
+
+            template<class T, T count, class F>
+            constexpr void loop(F&& f) {
+                loop_(std::make_integer_sequence<T, count>{}, std::forward<F>(f));
+            }
+
+            // JASER_FIELDS
+            template<typename ValT, typename = int>
+            struct has_jfields : std::false_type {};
+
+            template<typename ValT>
+            struct has_jfields<ValT, typename int_<decltype(std::declval<const ValT&>().jfields())>::type> : std::true_type {};
+
+            /// \brief the names in the stringised JASER_FIELDS list "a, b,c"
+            template <size_t Count>
+            constexpr std::array<std::string_view, Count> fieldKeys(const std::string_view& list) {
+                std::array<std::string_view, Count> keys{};
+                size_t i = 0;
+                for(size_t k = 0; k < Count; ++k){
+                    while((i < list.size()) && (list[i] == ' ')){
+                        ++i;
+                    }
+                    auto begin = i;
+                    while((i < list.size()) && (list[i] != ',') && (list[i] != ' ')){
+                        ++i;
+                    }
+                    keys[k] = list.substr(begin, i - begin);
+                    while((i < list.size()) && (list[i] != ',')){
+                        ++i;
+                    }
+                    ++i;
+                }
+                return keys;
+            }
+
+            // FNV-1a, as for Tree keys
+            constexpr uint32_t fieldHash(const std::string_view& key) {
+                uint32_t h = 2166136261u;
+                for(auto ch : key){
+                    h ^= static_cast<unsigned char>(ch);
+                    h *= 16777619u;
+                }
+                return h;
+            }
+
+            /// \brief open-addressing table of field index + 1, 0 for empty slots
+            template <size_t Slots, size_t Count>
+            constexpr std::array<uint16_t, Slots> fieldSlots(const std::array<std::string_view, Count>& keys) {
+                std::array<uint16_t, Slots> slots{};
+                for(size_t i = 0; i < Count; ++i){
+                    auto s = fieldHash(keys[i]) & (Slots - 1);
+                    while(slots[s] != 0){
+                        s = (s + 1) & (Slots - 1);
+                    }
+                    slots[s] = static_cast<uint16_t>(i + 1);
+                }
+                return slots;
+            }
+
+            constexpr size_t fieldSlotCount(const size_t& count) {
+                size_t slots = 4;
+                while(slots < count * 2){
+                    slots *= 2;
+                }
+                return slots;
+            }
+
+            /// \brief keys of the JASER_FIELDS members of ValT, all computed at compile time
+            template <typename ValT>
+            struct FieldTable {
+                static constexpr size_t count = std::tuple_size<decltype(std::declval<const ValT&>().jfields())>::value;
+                static constexpr size_t slots = fieldSlotCount(count);
+                static constexpr std::array<std::string_view, count> keys = fieldKeys<count>(ValT::jfieldNames());
+                static constexpr std::array<uint16_t, slots> table = fieldSlots<slots>(keys);
+
+                /// \brief index of the field named key, count if there is none.
+                /// next is the field after the last one found, so keys that come in
+                /// declaration order are matched with a single compare
+                static inline size_t find(const std::string_view& key, size_t& next) {
+                    if((next < count) && (keys[next] == key)){
+                        return next++;
+                    }
+                    for(auto s = fieldHash(key) & (slots - 1); table[s] != 0; s = (s + 1) & (slots - 1)){
+                        size_t idx = table[s] - 1u;
+                        if(keys[idx] == key){
+                            next = idx + 1;
+                            return idx;
+                        }
+                    }
+                    return count;
+                }
+            };
+
+            template <typename ValT>
+            inline void j2v_fields(const posdk::Json::Tree& jval, ValT& val);
+
+            template <typename ValT>
+            inline posdk::Json::Tree v2j_fields(const ValT& val);
+
+            template <typename ValT>
+            inline void j2v_fields(posdk::Json::Reader& reader, ValT& val);
+
+            template <typename ValT>
+            inline void v2j_fields(posdk::Json::Writer& writer, const ValT& val);
+
+            template<typename ValT, typename = typename std::enable_if< has_jfields<ValT>::value, ValT >::type>
+            inline ValT j2v(const posdk::Json::Tree& jval, const specializer_fields&) {
+                ValT val;
+                j2v_fields(jval, val);
+                return val;
+            }
+
+            template<typename ValT, typename = typename std::enable_if< has_jfields<ValT>::value, ValT >::type>
+            inline posdk::Json::Tree v2j(const ValT& val, const specializer_fields&) {
+                return v2j_fields(val);
+            }
+
+            template<typename ValT, typename = typename std::enable_if< has_jfields<ValT>::value, ValT >::type>
+            inline ValT j2v(posdk::Json::Reader& reader, const specializer_fields&) {
+                ValT val;
+                j2v_fields(reader, val);
+                return val;
+            }
+
+            template<typename ValT, typename = typename std::enable_if< has_jfields<ValT>::value, ValT >::type>
+            inline void v2j(posdk::Json::Writer& writer, const ValT& val, const specializer_fields&) {
+                v2j_fields(writer, val);
+            }
+
             // enums
             template<typename ValT, typename = typename std::enable_if< std::is_enum<ValT>::value, ValT >::type>
             inline ValT j2v(const posdk::Json::Tree& jval, const specializer_enum&) {
@@ -52,6 +258,17 @@ namespace posdk {
                 return jval;
             }
 
+            template<typename ValT, typename = typename std::enable_if< std::is_enum<ValT>::value, ValT >::type>
+            inline ValT j2v(posdk::Json::Reader& reader, const specializer_enum&) {
+                reader.expect(posdk::Json::Token::Value);
+                return s2e<ValT>(reader.value().getValue<std::string>());
+            }
+
+            template<typename ValT, typename = typename std::enable_if< std::is_enum<ValT>::value, ValT >::type>
+            inline void v2j(posdk::Json::Writer& writer, const ValT& val, const specializer_enum&) {
+                writer.value(e2s<ValT>(val));
+            }
+
             // variant
             template <typename... ValT>
             inline void j2v_variant(const posdk::Json::Tree& jval, std::variant<ValT...>& val);
@@ -59,6 +276,12 @@ namespace posdk {
             template<typename... ValT>
             inline posdk::Json::Tree v2j_variant(const std::variant<ValT...>& val);
 
+            template<typename... ValT>
+            inline void v2j_variant(posdk::Json::Writer& writer, const std::variant<ValT...>& val);
+
+            template <typename... ValT>
+            inline void j2v_variant(posdk::Json::Reader& reader, std::variant<ValT...>& val);
+
             // check if type is a variant (1)
             template<typename T>
             struct is_variant : std::false_type {};
@@ -78,6 +301,18 @@ namespace posdk {
                 return v2j_variant(val);
             }
 
+            template<typename ValT, typename = typename std::enable_if< is_variant<ValT>::value, ValT >::type>
+            inline ValT j2v(posdk::Json::Reader& reader, const specializer_variant&){
+                ValT val;
+                j2v_variant(reader, val);
+                return val;
+            }
+
+            template<typename ValT, typename = typename std::enable_if< is_variant<ValT>::value, ValT >::type>
+            inline void v2j(posdk::Json::Writer& writer, const ValT& val, const specializer_variant&){
+                v2j_variant(writer, val);
+            }
+
             // vector
             template <typename ValT>
             inline void j2v_vector(const posdk::Json::Tree& jval, std::vector<ValT>& val);
@@ -85,6 +320,12 @@ namespace posdk {
             template<typename ValT>
             inline posdk::Json::Tree v2j_vector(const std::vector<ValT>& val);
 
+            template<typename ValT>
+            inline void v2j_vector(posdk::Json::Writer& writer, const std::vector<ValT>& val);
+
+            template <typename ValT>
+            inline void j2v_vector(posdk::Json::Reader& reader, std::vector<ValT>& val);
+
             // check if type is a vector (1)
             template<typename T>
             struct is_vector : std::false_type {};
@@ -104,6 +345,18 @@ namespace posdk {
                 return v2j_vector(val);
             }
 
+            template<typename ValT, typename = typename std::enable_if< is_vector<ValT>::value, ValT >::type>
+            inline ValT j2v(posdk::Json::Reader& reader, const specializer_vector&){
+                ValT val;
+                j2v_vector(reader, val);
+                return val;
+            }
+
+            template<typename ValT, typename = typename std::enable_if< is_vector<ValT>::value, ValT >::type>
+            inline void v2j(posdk::Json::Writer& writer, const ValT& val, const specializer_vector&){
+                v2j_vector(writer, val);
+            }
+
             // map
             template <typename KeyT, typename ValT>
             inline void j2v_map(const posdk::Json::Tree& jval, std::map<KeyT,ValT>& val);
@@ -111,6 +364,12 @@ namespace posdk {
             template <typename KeyT, typename ValT>
             inline posdk::Json::Tree v2j_map(const std::map<KeyT,ValT>& val);
 
+            template <typename KeyT, typename ValT>
+            inline void v2j_map(posdk::Json::Writer& writer, const std::map<KeyT,ValT>& val);
+
+            template <typename KeyT, typename ValT>
+            inline void j2v_map(posdk::Json::Reader& reader, std::map<KeyT,ValT>& val);
+
             // check if type is a map (1)
             template<typename T>
             struct is_map : std::false_type {};
@@ -130,7 +389,19 @@ namespace posdk {
                 return v2j_map(val);
             }
 
-            // basic types
+            template<typename ValT, typename = typename std::enable_if< is_map<ValT>::value, ValT >::type>
+            inline ValT j2v(posdk::Json::Reader& reader, const specializer_map&){
+                ValT val;
+                j2v_map(reader, val);
+                return val;
+            }
+
+            template<typename ValT, typename = typename std::enable_if< is_map<ValT>::value, ValT >::type>
+            inline void v2j(posdk::Json::Writer& writer, const ValT& val, const specializer_map&){
+                v2j_map(writer, val);
+            }
+
+            // basic types, Tree range-checks integers and converts integers to floating point
             template <typename ValT>
             inline ValT j2v(const posdk::Json::Tree& jval, const specializer_basic&) {
                 return jval.getValue<ValT>();
@@ -141,6 +412,17 @@ namespace posdk {
                 return posdk::Json::Tree(val);
             }
 
+            template <typename ValT>
+            inline ValT j2v(posdk::Json::Reader& reader, const specializer_basic&) {
+                reader.expect(posdk::Json::Token::Value);
+                return reader.value().getValue<ValT>();
+            }
+
+            template <typename ValT>
+            inline void v2j(posdk::Json::Writer& writer, const ValT& val, const specializer_basic&) {
+                writer.value(val);
+            }
+
             // monostate
             template <>
             inline std::monostate j2v<std::monostate>(const posdk::Json::Tree&, const specializer_basic&) {
@@ -152,136 +434,33 @@ namespace posdk {
                 return posdk::Json::Tree();
             }
 
-            // json::Tree
-            template <>
-            inline posdk::Json::Tree j2v<posdk::Json::Tree>(const posdk::Json::Tree& jval, const specializer_basic&) {
-                return jval;
-            }
-
-            template <>
-            inline posdk::Json::Tree v2j<posdk::Json::Tree>(const posdk::Json::Tree& val, const specializer_basic&) {
-                return val;
-            }
-
-            //double
-            template <>
-            inline double j2v<double>(const posdk::Json::Tree& jval, const specializer_basic&) {
-                return static_cast<double>(jval.getValue<posdk::Json::float_t>());
-            }
-
-            template <>
-            inline posdk::Json::Tree v2j<double>(const double& val, const specializer_basic&) {
-                return posdk::Json::Tree(static_cast<posdk::Json::float_t>(val));
-            }
-
-            // int64_t
-            template <>
-            inline int64_t j2v<int64_t>(const posdk::Json::Tree& jval, const specializer_basic&) {
-                return static_cast<int64_t>(jval.getValue<posdk::Json::integer_t>());
-            }
-
-            template <>
-            inline posdk::Json::Tree v2j<int64_t>(const int64_t& val, const specializer_basic&) {
-                return posdk::Json::Tree(static_cast<posdk::Json::integer_t>(val));
-            }
-
-            // uint64_t
-            template <>
-            inline uint64_t j2v<uint64_t>(const posdk::Json::Tree& jval, const specializer_basic&) {
-                return static_cast<uint64_t>(jval.getValue<posdk::Json::integer_t>());
-            }
-
-            template <>
-            inline posdk::Json::Tree v2j<uint64_t>(const uint64_t& val, const specializer_basic&) {
-                return posdk::Json::Tree(static_cast<posdk::Json::integer_t>(val));
-            }
-
-            // int32_t
-            template <>
-            inline int32_t j2v<int32_t>(const posdk::Json::Tree& jval, const specializer_basic&) {
-                return static_cast<int32_t>(jval.getValue<posdk::Json::integer_t>());
-            }
-
-            template <>
-            inline posdk::Json::Tree v2j<int32_t>(const int32_t& val, const specializer_basic&) {
-                return posdk::Json::Tree(static_cast<posdk::Json::integer_t>(val));
-            }
-
-            // uint32_t
-            template <>
-            inline uint32_t j2v<uint32_t>(const posdk::Json::Tree& jval, const specializer_basic&) {
-                return static_cast<uint32_t>(jval.getValue<posdk::Json::integer_t>());
-            }
-
-            template <>
-            inline posdk::Json::Tree v2j<uint32_t>(const uint32_t& val, const specializer_basic&) {
-                return posdk::Json::Tree(static_cast<posdk::Json::integer_t>(val));
-            }
-
-            // int16_t
-            template <>
-            inline int16_t j2v<int16_t>(const posdk::Json::Tree& jval, const specializer_basic&) {
-                return static_cast<int16_t>(jval.getValue<posdk::Json::integer_t>());
-            }
-
-            template <>
-            inline posdk::Json::Tree v2j<int16_t>(const int16_t& val, const specializer_basic&) {
-                return posdk::Json::Tree(static_cast<posdk::Json::integer_t>(val));
-            }
-
-            // uint16_t
-            template <>
-            inline uint16_t j2v<uint16_t>(const posdk::Json::Tree& jval, const specializer_basic&) {
-                return static_cast<uint16_t>(jval.getValue<posdk::Json::integer_t>());
-            }
-
             template <>
-            inline posdk::Json::Tree v2j<uint16_t>(const uint16_t& val, const specializer_basic&) {
-                return posdk::Json::Tree(static_cast<posdk::Json::integer_t>(val));
+            inline void v2j<std::monostate>(posdk::Json::Writer& writer, const std::monostate&, const specializer_basic&) {
+                writer.null();
             }
 
-            // int8_t
             template <>
-            inline int8_t j2v<int8_t>(const posdk::Json::Tree& jval, const specializer_basic&) {
-                return static_cast<int8_t>(jval.getValue<posdk::Json::integer_t>());
-            }
-
-            template <>
-            inline posdk::Json::Tree v2j<int8_t>(const int8_t& val, const specializer_basic&) {
-                return posdk::Json::Tree(static_cast<posdk::Json::integer_t>(val));
-            }
-
-            // uint8_t
-            template <>
-            inline uint8_t j2v<uint8_t>(const posdk::Json::Tree& jval, const specializer_basic&) {
-                return static_cast<uint8_t>(jval.getValue<posdk::Json::integer_t>());
+            inline std::monostate j2v<std::monostate>(posdk::Json::Reader& reader, const specializer_basic&) {
+                reader.skip();
+                return std::monostate();
             }
 
+            // json::Tree
             template <>
-            inline posdk::Json::Tree v2j<uint8_t>(const uint8_t& val, const specializer_basic&) {
-                return posdk::Json::Tree(static_cast<posdk::Json::integer_t>(val));
+            inline posdk::Json::Tree j2v<posdk::Json::Tree>(const posdk::Json::Tree& jval, const specializer_basic&) {
+                return jval;
             }
 
-            // char
             template <>
-            inline char j2v<char>(const posdk::Json::Tree& jval, const specializer_basic&) {
-                return static_cast<char>(jval.getValue<posdk::Json::integer_t>());
+            inline posdk::Json::Tree v2j<posdk::Json::Tree>(const posdk::Json::Tree& val, const specializer_basic&) {
+                return val;
             }
 
             template <>
-            inline posdk::Json::Tree v2j<char>(const char& val, const specializer_basic&) {
-                return posdk::Json::Tree(static_cast<posdk::Json::integer_t>(val));
-            }
-
-            // looper (used in variant converter)
-            template<class T, T... inds, class F>
-            constexpr void loop_(std::integer_sequence<T, inds...>, F&& f) {
-                (f(std::integral_constant<T, inds>{}), ...);// C++17 fold expression
-            }
-
-            template<class T, T count, class F>
-            constexpr void loop(F&& f) {
-                loop_(std::make_integer_sequence<T, count>{}, std::forward<F>(f));
+            inline posdk::Json::Tree j2v<posdk::Json::Tree>(posdk::Json::Reader& reader, const specializer_basic&) {
+                posdk::Json::Tree jval;
+                reader.read(jval);
+                return jval;
             }
 
             // variant helpers. these need to be at the bottom of the list
@@ -315,18 +494,90 @@ namespace posdk {
                     typedef typename std::remove_const<ConstType>::type Type;
 
                     auto jdata = Json_::v2j<Type>(x, Json_::specializer());
-                    jval.add("__data__", jdata);
+                    jval.add("__data__", std::move(jdata));
                 }, val);
 
                 return jval;
             }
 
+            /// \brief __data__ is read straight into the alternative when __varidx__ comes
+            /// first, as written by v2j_variant, otherwise it is held in a Tree until then
+            template <typename... ValT>
+            inline void j2v_variant(posdk::Json::Reader& reader, std::variant<ValT...>& val) {
+                size_t varidx = sizeof...(ValT);
+                bool done = false;
+                std::optional<posdk::Json::Tree> jdata;
+                auto assign = [&](auto&& src) {
+                    loop<size_t, sizeof...(ValT)>([&] (auto i) {
+                        constexpr size_t idx = i;
+                        if(idx == varidx){
+                            typedef typename std::variant_alternative<idx, std::variant<ValT...>>::type Type;
+                            val = Json_::j2v<Type>(src, Json_::specializer());
+                        }
+                    });
+                };
+
+                reader.expect(posdk::Json::Token::BeginObject);
+                while(reader.next() == posdk::Json::Token::Key) {
+                    if(reader.key() == "__varidx__") {
+                        varidx = Json_::j2v<size_t>(reader, Json_::specializer());
+                        if(varidx >= sizeof...(ValT)) {
+                            throw posdk::JsonError("variant index out of range:" + std::to_string(varidx));
+                        }
+                    }else if((reader.key() == "__data__") && (varidx < sizeof...(ValT))) {
+                        assign(reader);
+                        done = true;
+                    }else if(reader.key() == "__data__") {
+                        jdata.emplace();
+                        reader.read(*jdata);
+                    }else{
+                        reader.skip();
+                    }
+                }
+                if(!done) {
+                    if(!jdata || (varidx >= sizeof...(ValT))) {
+                        throw posdk::JsonError("variant without __varidx__ or __data__");
+                    }
+                    assign(static_cast<const posdk::Json::Tree&>(*jdata));
+                }
+            }
+
+            template<typename... ValT>
+            inline void v2j_variant(posdk::Json::Writer& writer, const std::variant<ValT...>& val){
+                writer.beginObject();
+                writer.key("__varidx__");
+                writer.value(static_cast<posdk::Json::integer_t>(val.index()));
+
+                std::visit([&writer](const auto& x){
+                    typedef decltype(x) TypeRef;
+                    typedef typename std::remove_reference<TypeRef>::type ConstType;
+                    typedef typename std::remove_const<ConstType>::type Type;
+
+                    writer.key("__data__");
+                    Json_::v2j<Type>(writer, x, Json_::specializer());
+                }, val);
+                writer.endObject();
+            }
+
             // vector helpers
+            // vectors of numbers are read from packed Tree arrays and the base64 form, see
+            // Tree::packed() and Writer::packArrays(). v2j() builds a node per element
             template <typename ValT>
             inline void j2v_vector(const posdk::Json::Tree& jval, std::vector<ValT>& val) {
+                if constexpr (posdk::Json::isPackable<ValT>::value) {
+                    if(jval.isPacked()){
+                        jval.unpack(val);
+                        return;
+                    }
+                    if(jval.isObject()){
+                        posdk::Json::unpackBase64(jval.get<std::string_view>("__packed__"), jval.get<std::string_view>("__data__"), val);
+                        return;
+                    }
+                    val.reserve(val.size() + jval.size());
+                }
                 for(auto& jdata : jval){
                     auto aval = Json_::j2v<ValT>(jdata.second, specializer());
-                    val.push_back(aval);
+                    val.push_back(std::move(aval));
                 }
             }
 
@@ -335,11 +586,69 @@ namespace posdk {
                 posdk::Json::Tree jval(posdk::Json::DataType::Array);
                 for(auto& x : val){
                     auto jdata = Json_::v2j<ValT>(x, specializer());
-                    jval.add(jdata);
+                    jval.add(std::move(jdata));
                 }
                 return jval;
             }
 
+            /// \brief numbers are read in one loop over the Value tokens, or decoded
+            /// from the base64 packed form
+            template <typename ValT>
+            inline void j2v_packed(posdk::Json::Reader& reader, std::vector<ValT>& val) {
+                if(reader.peek() == posdk::Json::Token::BeginObject) {
+                    reader.next();
+                    std::string name;
+                    std::string data;
+                    while(reader.next() == posdk::Json::Token::Key) {
+                        if(reader.key() == "__packed__") {
+                            reader.expect(posdk::Json::Token::Value);
+                            name = reader.value().getValue<std::string>();
+                        }else if(reader.key() == "__data__") {
+                            reader.expect(posdk::Json::Token::Value);
+                            data = reader.value().getValue<std::string>();
+                        }else{
+                            reader.skip();
+                        }
+                    }
+                    posdk::Json::unpackBase64(name, data, val);
+                    return;
+                }
+                reader.expect(posdk::Json::Token::BeginArray);
+                posdk::Json::Token tok;
+                while((tok = reader.next()) == posdk::Json::Token::Value){
+                    val.push_back(reader.value().getValue<ValT>());
+                }
+                if(tok != posdk::Json::Token::EndArray) {
+                    throw posdk::JsonError("{0}: unexpected token in json", reader.pos());
+                }
+            }
+
+            template <typename ValT>
+            inline void j2v_vector(posdk::Json::Reader& reader, std::vector<ValT>& val) {
+                if constexpr (posdk::Json::isPackable<ValT>::value) {
+                    j2v_packed(reader, val);
+                } else {
+                    reader.expect(posdk::Json::Token::BeginArray);
+                    while(reader.peek() != posdk::Json::Token::EndArray){
+                        val.push_back(Json_::j2v<ValT>(reader, specializer()));
+                    }
+                    reader.next();
+                }
+            }
+
+            template<typename ValT>
+            inline void v2j_vector(posdk::Json::Writer& writer, const std::vector<ValT>& val) {
+                if constexpr (posdk::Json::isPackable<ValT>::value) {
+                    writer.values(val.data(), val.size());
+                } else {
+                    writer.beginArray();
+                    for(auto& x : val){
+                        Json_::v2j<ValT>(writer, x, specializer());
+                    }
+                    writer.endArray();
+                }
+            }
+
             // map helpers
             template <typename KeyT, typename ValT>
             inline void j2v_map(const posdk::Json::Tree& jmap, std::map<KeyT,ValT>& val) {
@@ -348,7 +657,7 @@ namespace posdk {
                     auto& jval = jitem.second.getChild("__val__");
                     auto akey = Json_::j2v<KeyT>(jkey, specializer());
                     auto aval = Json_::j2v<ValT>(jval, specializer());
-                    val[akey] = aval;
+                    val[std::move(akey)] = std::move(aval);
                 }
             }
 
@@ -359,12 +668,123 @@ namespace posdk {
                     auto jkey = Json_::v2j<KeyT>(x.first, specializer());
                     auto jval = Json_::v2j<ValT>(x.second, specializer());
                     posdk::Json::Tree jpair(posdk::Json::DataType::Object);
-                    jpair.add("__key__", jkey);
-                    jpair.add("__val__", jval);
-                    jret.add(jpair);
+                    jpair.add("__key__", std::move(jkey));
+                    jpair.add("__val__", std::move(jval));
+                    jret.add(std::move(jpair));
                 }
                 return jret;
             }
+
+            template <typename KeyT, typename ValT>
+            inline void j2v_map(posdk::Json::Reader& reader, std::map<KeyT,ValT>& val) {
+                reader.expect(posdk::Json::Token::BeginArray);
+                while(reader.peek() != posdk::Json::Token::EndArray){
+                    std::optional<KeyT> akey;
+                    std::optional<ValT> aval;
+                    reader.expect(posdk::Json::Token::BeginObject);
+                    while(reader.next() == posdk::Json::Token::Key) {
+                        if(reader.key() == "__key__") {
+                            akey = Json_::j2v<KeyT>(reader, specializer());
+                        }else if(reader.key() == "__val__") {
+                            aval = Json_::j2v<ValT>(reader, specializer());
+                        }else{
+                            reader.skip();
+                        }
+                    }
+                    if(!akey || !aval) {
+                        throw posdk::JsonError("map entry without __key__ or __val__");
+                    }
+                    val[std::move(*akey)] = std::move(*aval);
+                }
+                reader.next();
+            }
+
+            template <typename KeyT, typename ValT>
+            inline void v2j_map(posdk::Json::Writer& writer, const std::map<KeyT,ValT>& val) {
+                writer.beginArray();
+                for(auto& x : val){
+                    writer.beginObject();
+                    writer.key("__key__");
+                    Json_::v2j<KeyT>(writer, x.first, specializer());
+                    writer.key("__val__");
+                    Json_::v2j<ValT>(writer, x.second, specializer());
+                    writer.endObject();
+                }
+                writer.endArray();
+            }
+
+            // JASER_FIELDS helpers
+            template <typename SrcT, typename FieldT>
+            inline void j2v_field(SrcT& src, FieldT& field) {
+                field = Json_::j2v<FieldT>(src, specializer());
+            }
+
+            /// \brief read the idx'th field from src, a Tree or a Reader
+            template <typename SrcT, typename TupleT, size_t... Idx>
+            inline void j2v_fieldAt(SrcT& src, TupleT& fields, const size_t& idx, std::index_sequence<Idx...>) {
+                (void)(((idx == Idx) && (j2v_field(src, std::get<Idx>(fields)), true)) || ...);
+            }
+
+            template <typename ValT>
+            inline void j2v_fields(const posdk::Json::Tree& jval, ValT& val) {
+                typedef FieldTable<ValT> Table;
+                if(!jval.isObject()) {
+                    throw posdk::JsonError("attempting to read fields from non-object");
+                }
+                auto fields = val.jfields();
+                size_t next = 0;
+                for(auto& jitem : jval){
+                    auto idx = Table::find(jitem.first, next);
+                    if(idx < Table::count){
+                        j2v_fieldAt(jitem.second, fields, idx, std::make_index_sequence<Table::count>());
+                    }
+                }
+            }
+
+            /// \brief keys are borrowed from the JASER_FIELDS string literal, not copied
+            template <typename ValT>
+            inline posdk::Json::Tree v2j_fields(const ValT& val) {
+                typedef FieldTable<ValT> Table;
+                posdk::Json::Tree jval(posdk::Json::DataType::Object);
+                jval.reserve(Table::count);
+                auto fields = val.jfields();
+                loop<size_t, Table::count>([&](auto i) {
+                    constexpr size_t idx = i;
+                    typedef typename std::decay<decltype(std::get<idx>(fields))>::type FieldT;
+                    jval.addBorrowed(Table::keys[idx], Json_::v2j<FieldT>(std::get<idx>(fields), specializer()));
+                });
+                return jval;
+            }
+
+            template <typename ValT>
+            inline void j2v_fields(posdk::Json::Reader& reader, ValT& val) {
+                typedef FieldTable<ValT> Table;
+                auto fields = val.jfields();
+                size_t next = 0;
+                reader.expect(posdk::Json::Token::BeginObject);
+                while(reader.next() == posdk::Json::Token::Key) {
+                    auto idx = Table::find(reader.key(), next);
+                    if(idx < Table::count){
+                        j2v_fieldAt(reader, fields, idx, std::make_index_sequence<Table::count>());
+                    }else{
+                        reader.skip();
+                    }
+                }
+            }
+
+            template <typename ValT>
+            inline void v2j_fields(posdk::Json::Writer& writer, const ValT& val) {
+                typedef FieldTable<ValT> Table;
+                auto fields = val.jfields();
+                writer.beginObject();
+                loop<size_t, Table::count>([&](auto i) {
+                    constexpr size_t idx = i;
+                    typedef typename std::decay<decltype(std::get<idx>(fields))>::type FieldT;
+                    writer.key(Table::keys[idx]);
+                    Json_::v2j<FieldT>(writer, std::get<idx>(fields), specializer());
+                });
+                writer.endObject();
+            }
         }
 
         /// \brief convert from JSON
@@ -380,18 +800,114 @@ namespace posdk {
             return jval;
         }
 
+        /// \brief read from JSON, without building a Tree
+        template <typename ValT>
+        inline ValT j2v(posdk::Json::Reader& reader) {
+            return Json_::j2v<ValT>(reader, Json_::specializer());
+        }
+
+        /// \brief write as JSON, without building a Tree
+        template <typename ValT>
+        inline void v2j(posdk::Json::Writer& writer, const ValT& val) {
+            Json_::v2j<ValT>(writer, val, Json_::specializer());
+        }
+
+        /// \brief read the next line of NDJSON, false at the end
+        /// throws if the line holds anything after the value
+        template <typename ValT>
+        inline bool jnext(posdk::Json::LineReader& lines, ValT& val) {
+            auto reader = lines.nextReader();
+            if(reader == nullptr) {
+                return false;
+            }
+            val = Json_::j2v<ValT>(*reader, Json_::specializer());
+            reader->expectEnd();
+            return true;
+        }
+
+        /// \brief read NDJSON on several threads and call fn(ValT&) for each record
+        /// the records of a chunk are converted by one thread and handed to fn as set by popts
+        template <typename ValT, typename FnT>
+        inline void j2vLines(const std::string_view& buf, const std::string& filename, FnT&& fn, const posdk::Json::ParseOptions& opts = posdk::Json::ParseOptions(), const posdk::Json::ParallelOptions& popts = posdk::Json::ParallelOptions()) {
+            posdk::Json::LineChunks chunks(buf, popts);
+            std::vector<std::vector<ValT>> records(chunks.slots());
+            chunks.run([&](const size_t& slot, const std::string_view& text, const size_t& firstLine) {
+                auto& list = records[slot];
+                list.clear();
+                posdk::Json::LineReader lines(text, filename, opts, firstLine);
+                ValT val;
+                while(jnext(lines, val)) {
+                    list.push_back(std::move(val));
+                }
+            }, [&](const size_t& slot) {
+                for(auto& val : records[slot]) {
+                    fn(val);
+                }
+            });
+        }
+
+        /// \brief read a large top level array on several threads, see ArrayChunks
+        /// anything that is not an array, and text that is not valid json, is read again serially
+        /// by j2v(), which throws with the position in the buffer. errors converting a valid
+        /// element are thrown as they are
+        template <typename ValT>
+        inline std::vector<ValT> j2vArray(const std::string_view& buf, const std::string& filename, const posdk::Json::ParseOptions& opts = posdk::Json::ParseOptions(), const posdk::Json::ParallelOptions& popts = posdk::Json::ParallelOptions()) {
+            posdk::Json::ArrayChunks chunks(buf, filename, opts, popts);
+            std::vector<std::vector<ValT>> elements(chunks.slots());
+            std::vector<ValT> val;
+            try {
+                auto split = chunks.run([&elements](const size_t& slot, posdk::Json::Reader& reader) {
+                    elements[slot].push_back(Json_::j2v<ValT>(reader, Json_::specializer()));
+                }, [&elements, &val](const size_t& slot) {
+                    auto& list = elements[slot];
+                    std::move(list.begin(), list.end(), std::back_inserter(val));
+                    list.clear();
+                });
+                if(split) {
+                    return val;
+                }
+            }catch(const posdk::JsonError&) {
+                if(!chunks.malformed()) {
+                    throw;
+                }
+            }
+            posdk::Json::Reader reader(buf, filename, opts);
+            return Json_::j2v<std::vector<ValT>>(reader, Json_::specializer());
+        }
+
+        /// \brief write val as one line of NDJSON, the writer should have an indent of 0
+        template <typename ValT>
+        inline void jline(posdk::Json::Writer& writer, const ValT& val) {
+            Json_::v2j<ValT>(writer, val, Json_::specializer());
+            writer.endLine();
+        }
+
         /// \brief convert from JSON
         template <typename ValT>
-        inline ValT jget(const posdk::Json::Tree& jobj, const std::string& key, const ValT&) {
+        inline ValT jget(const posdk::Json::Tree& jobj, const std::string_view& key, const ValT&) {
             auto& jval = jobj.getChild(key);
             return Json_::j2v<ValT>(jval, Json_::specializer());
         }
 
+        /// \brief read the value of the current key from JSON, for use in jload()
+        template <typename ValT>
+        inline bool jget(posdk::Json::Reader& reader, ValT& val) {
+            val = Json_::j2v<ValT>(reader, Json_::specializer());
+            return true;
+        }
+
         /// \brief convert to JSON
         template <typename ValT>
-        inline void jset(posdk::Json::Tree& jobj, const std::string& key, const ValT& val) {
+        inline void jset(posdk::Json::Tree& jobj, const std::string_view& key, const ValT& val) {
             auto jval = Json_::v2j<ValT>(val, Json_::specializer());
-            jobj.add(key, jval);
+            jobj.add(key, std::move(jval));
+        }
+
+        /// \brief write as JSON, for use in jsave(Writer&)
+        template <typename ValT>
+        inline void jset(posdk::Json::Writer& writer, const std::string_view& key, const ValT& val) {
+            writer.key(key);
+            Json_::v2j<ValT>(writer, val, Json_::specializer());
         }
     }
 }